@@ -85,8 +85,30 @@
 #define BOOST_NOWIDE_FALLTHROUGH BOOST_FALLTHROUGH
 #endif
 
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define BOOST_NOWIDE_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(BOOST_NOWIDE_IS_CONSTANT_EVALUATED) \
+  && ((defined(BOOST_GCC) && __GNUC__ >= 9) || (defined(BOOST_MSVC) && BOOST_MSVC >= 1925))
+#define BOOST_NOWIDE_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
 //! @endcond
 
+/// @def BOOST_NOWIDE_CONSTEXPR_CONVERT
+/// @brief Expands to `constexpr` if utf::convert_buffer and the functions it uses can be evaluated at compile time.
+///
+/// This requires C++14 and a compiler which can detect constant evaluation to not use the SIMD kernels.
+/// Otherwise it is empty and #BOOST_NOWIDE_NO_CONSTEXPR_CONVERT is defined.
+#if defined(BOOST_NOWIDE_IS_CONSTANT_EVALUATED) && !defined(BOOST_NO_CXX14_CONSTEXPR)
+#define BOOST_NOWIDE_CONSTEXPR_CONVERT constexpr
+#else
+#define BOOST_NOWIDE_CONSTEXPR_CONVERT
+#define BOOST_NOWIDE_NO_CONSTEXPR_CONVERT
+#endif
+
 namespace boost {
 ///
 /// \brief This namespace includes implementations of the standard library functions and
@@ -28,6 +28,15 @@ namespace nowide {
         return utf::convert_buffer(output, output_size, begin, end);
     }
     ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename Policy, typename = detail::requires_error_policy<Policy>>
+    inline char* narrow(char* output, size_t output_size, const wchar_t* begin, const wchar_t* end, Policy policy)
+    {
+        return utf::convert_buffer(output, output_size, begin, end, policy);
+    }
+    ///
     /// Convert NULL terminated wide string (UTF-16/32) to NULL terminated narrow string (UTF-8)
     /// stored in \a output of size \a output_size (including NULL)
     ///
@@ -36,7 +45,16 @@ namespace nowide {
     ///
     inline char* narrow(char* output, size_t output_size, const wchar_t* source)
     {
-        return narrow(output, output_size, source, source + utf::strlen(source));
+        return utf::convert_buffer(output, output_size, source);
+    }
+    ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename Policy, typename = detail::requires_error_policy<Policy>>
+    inline char* narrow(char* output, size_t output_size, const wchar_t* source, Policy policy)
+    {
+        return utf::convert_buffer(output, output_size, source, policy);
     }
 
     ///
@@ -51,6 +69,15 @@ namespace nowide {
         return utf::convert_buffer(output, output_size, begin, end);
     }
     ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename Policy, typename = detail::requires_error_policy<Policy>>
+    inline wchar_t* widen(wchar_t* output, size_t output_size, const char* begin, const char* end, Policy policy)
+    {
+        return utf::convert_buffer(output, output_size, begin, end, policy);
+    }
+    ///
     /// Convert NULL terminated narrow string (UTF-8) to NULL terminated wide string (UTF-16/32)
     /// most output_size (including NULL)
     ///
@@ -59,7 +86,16 @@ namespace nowide {
     ///
     inline wchar_t* widen(wchar_t* output, size_t output_size, const char* source)
     {
-        return widen(output, output_size, source, source + utf::strlen(source));
+        return utf::convert_buffer(output, output_size, source);
+    }
+    ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename Policy, typename = detail::requires_error_policy<Policy>>
+    inline wchar_t* widen(wchar_t* output, size_t output_size, const char* source, Policy policy)
+    {
+        return utf::convert_buffer(output, output_size, source, policy);
     }
 
     ///
@@ -75,6 +111,18 @@ namespace nowide {
         return utf::convert_string<char>(s, s + count);
     }
     ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename T_Char,
+             typename Policy,
+             typename = detail::requires_wide_char<T_Char>,
+             typename = detail::requires_error_policy<Policy>>
+    inline std::string narrow(const T_Char* s, size_t count, Policy policy)
+    {
+        return utf::convert_string<char>(s, s + count, policy);
+    }
+    ///
     /// Convert wide string (UTF-16/32) to narrow string (UTF-8).
     ///
     /// \param s NULL terminated input string
@@ -83,7 +131,19 @@ namespace nowide {
     template<typename T_Char, typename = detail::requires_wide_char<T_Char>>
     inline std::string narrow(const T_Char* s)
     {
-        return narrow(s, utf::strlen(s));
+        return utf::convert_string<char>(s);
+    }
+    ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename T_Char,
+             typename Policy,
+             typename = detail::requires_wide_char<T_Char>,
+             typename = detail::requires_error_policy<Policy>>
+    inline std::string narrow(const T_Char* s, Policy policy)
+    {
+        return utf::convert_string<char>(s, policy);
     }
     ///
     /// Convert wide string (UTF-16/32) to narrow string (UTF-8).
@@ -96,6 +156,18 @@ namespace nowide {
     {
         return utf::convert_string<char>(s.data(), s.data() + s.size());
     }
+    ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename StringOrStringView,
+             typename Policy,
+             typename = detail::requires_wide_string_container<StringOrStringView>,
+             typename = detail::requires_error_policy<Policy>>
+    inline std::string narrow(const StringOrStringView& s, Policy policy)
+    {
+        return utf::convert_string<char>(s.data(), s.data() + s.size(), policy);
+    }
 
     ///
     /// Convert narrow string (UTF-8) to wide string (UTF-16/32).
@@ -110,6 +182,18 @@ namespace nowide {
         return utf::convert_string<wchar_t>(s, s + count);
     }
     ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename T_Char,
+             typename Policy,
+             typename = detail::requires_narrow_char<T_Char>,
+             typename = detail::requires_error_policy<Policy>>
+    inline std::wstring widen(const T_Char* s, size_t count, Policy policy)
+    {
+        return utf::convert_string<wchar_t>(s, s + count, policy);
+    }
+    ///
     /// Convert narrow string (UTF-8) to wide string (UTF-16/32).
     ///
     /// \param s NULL terminated input string
@@ -118,7 +202,19 @@ namespace nowide {
     template<typename T_Char, typename = detail::requires_narrow_char<T_Char>>
     inline std::wstring widen(const T_Char* s)
     {
-        return widen(s, utf::strlen(s));
+        return utf::convert_string<wchar_t>(s);
+    }
+    ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename T_Char,
+             typename Policy,
+             typename = detail::requires_narrow_char<T_Char>,
+             typename = detail::requires_error_policy<Policy>>
+    inline std::wstring widen(const T_Char* s, Policy policy)
+    {
+        return utf::convert_string<wchar_t>(s, policy);
     }
     ///
     /// Convert narrow string (UTF-8) to wide string (UTF-16/32).
@@ -131,6 +227,299 @@ namespace nowide {
     {
         return utf::convert_string<wchar_t>(s.data(), s.data() + s.size());
     }
+    ///
+    /// Same as above but invalid sequences are handled according to the error \a policy,
+    /// see utf::replace, utf::strict and utf::assume_valid
+    ///
+    template<typename StringOrStringView,
+             typename Policy,
+             typename = detail::requires_narrow_string_container<StringOrStringView>,
+             typename = detail::requires_error_policy<Policy>>
+    inline std::wstring widen(const StringOrStringView& s, Policy policy)
+    {
+        return utf::convert_string<wchar_t>(s.data(), s.data() + s.size(), policy);
+    }
+    ///
+    /// Convert wide string (UTF-16/32) to narrow string (UTF-8) and store it in \a out, replacing its content.
+    ///
+    /// The capacity of \a out is reused, memory is only allocated if it is too small.
+    /// \param out Output string
+    /// \param s Input string
+    /// \param count Number of characters to convert
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_wide_char<T_Char>>
+    inline std::string& narrow_into(std::string& out, const T_Char* s, size_t count)
+    {
+        out.clear();
+        return utf::convert_append(out, s, s + count);
+    }
+    ///
+    /// Convert wide string (UTF-16/32) to narrow string (UTF-8) and store it in \a out, replacing its content.
+    ///
+    /// \param out Output string
+    /// \param s NULL terminated input string
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_wide_char<T_Char>>
+    inline std::string& narrow_into(std::string& out, const T_Char* s)
+    {
+        out.clear();
+        return utf::convert_append(out, s);
+    }
+    ///
+    /// Convert wide string (UTF-16/32) to narrow string (UTF-8) and store it in \a out, replacing its content.
+    ///
+    /// \param out Output string
+    /// \param s Input string
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename StringOrStringView, typename = detail::requires_wide_string_container<StringOrStringView>>
+    inline std::string& narrow_into(std::string& out, const StringOrStringView& s)
+    {
+        return narrow_into(out, s.data(), s.size());
+    }
+
+    ///
+    /// Convert wide string (UTF-16/32) to narrow string (UTF-8) and append it to \a out.
+    ///
+    /// The capacity of \a out is reused, memory is only allocated if it is too small.
+    /// \param out Output string
+    /// \param s Input string
+    /// \param count Number of characters to convert
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_wide_char<T_Char>>
+    inline std::string& narrow_append(std::string& out, const T_Char* s, size_t count)
+    {
+        return utf::convert_append(out, s, s + count);
+    }
+    ///
+    /// Convert wide string (UTF-16/32) to narrow string (UTF-8) and append it to \a out.
+    ///
+    /// \param out Output string
+    /// \param s NULL terminated input string
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_wide_char<T_Char>>
+    inline std::string& narrow_append(std::string& out, const T_Char* s)
+    {
+        return utf::convert_append(out, s);
+    }
+    ///
+    /// Convert wide string (UTF-16/32) to narrow string (UTF-8) and append it to \a out.
+    ///
+    /// \param out Output string
+    /// \param s Input string
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename StringOrStringView, typename = detail::requires_wide_string_container<StringOrStringView>>
+    inline std::string& narrow_append(std::string& out, const StringOrStringView& s)
+    {
+        return narrow_append(out, s.data(), s.size());
+    }
+
+    ///
+    /// Convert narrow string (UTF-8) to wide string (UTF-16/32) and store it in \a out, replacing its content.
+    ///
+    /// The capacity of \a out is reused, memory is only allocated if it is too small.
+    /// \param out Output string
+    /// \param s Input string
+    /// \param count Number of characters to convert
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_narrow_char<T_Char>>
+    inline std::wstring& widen_into(std::wstring& out, const T_Char* s, size_t count)
+    {
+        out.clear();
+        return utf::convert_append(out, s, s + count);
+    }
+    ///
+    /// Convert narrow string (UTF-8) to wide string (UTF-16/32) and store it in \a out, replacing its content.
+    ///
+    /// \param out Output string
+    /// \param s NULL terminated input string
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_narrow_char<T_Char>>
+    inline std::wstring& widen_into(std::wstring& out, const T_Char* s)
+    {
+        out.clear();
+        return utf::convert_append(out, s);
+    }
+    ///
+    /// Convert narrow string (UTF-8) to wide string (UTF-16/32) and store it in \a out, replacing its content.
+    ///
+    /// \param out Output string
+    /// \param s Input string
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename StringOrStringView, typename = detail::requires_narrow_string_container<StringOrStringView>>
+    inline std::wstring& widen_into(std::wstring& out, const StringOrStringView& s)
+    {
+        return widen_into(out, s.data(), s.size());
+    }
+
+    ///
+    /// Convert narrow string (UTF-8) to wide string (UTF-16/32) and append it to \a out.
+    ///
+    /// The capacity of \a out is reused, memory is only allocated if it is too small.
+    /// \param out Output string
+    /// \param s Input string
+    /// \param count Number of characters to convert
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_narrow_char<T_Char>>
+    inline std::wstring& widen_append(std::wstring& out, const T_Char* s, size_t count)
+    {
+        return utf::convert_append(out, s, s + count);
+    }
+    ///
+    /// Convert narrow string (UTF-8) to wide string (UTF-16/32) and append it to \a out.
+    ///
+    /// \param out Output string
+    /// \param s NULL terminated input string
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_narrow_char<T_Char>>
+    inline std::wstring& widen_append(std::wstring& out, const T_Char* s)
+    {
+        return utf::convert_append(out, s);
+    }
+    ///
+    /// Convert narrow string (UTF-8) to wide string (UTF-16/32) and append it to \a out.
+    ///
+    /// \param out Output string
+    /// \param s Input string
+    /// \return \a out
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename StringOrStringView, typename = detail::requires_narrow_string_container<StringOrStringView>>
+    inline std::wstring& widen_append(std::wstring& out, const StringOrStringView& s)
+    {
+        return widen_append(out, s.data(), s.size());
+    }
+
+    ///
+    /// Convert a UTF string of any character type to a UTF-16 string.
+    ///
+    /// \param s Input string
+    /// \param count Number of characters to convert
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_char<T_Char>>
+    inline std::u16string to_u16string(const T_Char* s, size_t count)
+    {
+        return utf::convert_string<char16_t>(s, s + count);
+    }
+    ///
+    /// Convert a UTF string of any character type to a UTF-16 string.
+    ///
+    /// \param s NULL terminated input string
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_char<T_Char>>
+    inline std::u16string to_u16string(const T_Char* s)
+    {
+        return utf::convert_string<char16_t>(s);
+    }
+    ///
+    /// Convert a UTF string of any character type to a UTF-16 string.
+    ///
+    /// \param s Input string
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename StringOrStringView, typename = detail::requires_string_container<StringOrStringView>>
+    inline std::u16string to_u16string(const StringOrStringView& s)
+    {
+        return utf::convert_string<char16_t>(s.data(), s.data() + s.size());
+    }
+
+    ///
+    /// Convert a UTF string of any character type to a UTF-32 string.
+    ///
+    /// \param s Input string
+    /// \param count Number of characters to convert
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_char<T_Char>>
+    inline std::u32string to_u32string(const T_Char* s, size_t count)
+    {
+        return utf::convert_string<char32_t>(s, s + count);
+    }
+    ///
+    /// Convert a UTF string of any character type to a UTF-32 string.
+    ///
+    /// \param s NULL terminated input string
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_char<T_Char>>
+    inline std::u32string to_u32string(const T_Char* s)
+    {
+        return utf::convert_string<char32_t>(s);
+    }
+    ///
+    /// Convert a UTF string of any character type to a UTF-32 string.
+    ///
+    /// \param s Input string
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename StringOrStringView, typename = detail::requires_string_container<StringOrStringView>>
+    inline std::u32string to_u32string(const StringOrStringView& s)
+    {
+        return utf::convert_string<char32_t>(s.data(), s.data() + s.size());
+    }
+
+#ifdef __cpp_lib_char8_t
+    ///
+    /// Convert a UTF string of any character type to a UTF-8 string of `char8_t`.
+    ///
+    /// Conversions from `char` copy the valid parts of the input in bulk
+    /// and those from wide strings use the same kernels as #narrow.
+    ///
+    /// \param s Input string
+    /// \param count Number of characters to convert
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_char<T_Char>>
+    inline std::u8string to_u8string(const T_Char* s, size_t count)
+    {
+        return utf::convert_string<char8_t>(s, s + count);
+    }
+    ///
+    /// Convert a UTF string of any character type to a UTF-8 string of `char8_t`.
+    ///
+    /// \param s NULL terminated input string
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename T_Char, typename = detail::requires_char<T_Char>>
+    inline std::u8string to_u8string(const T_Char* s)
+    {
+        return utf::convert_string<char8_t>(s);
+    }
+    ///
+    /// Convert a UTF string of any character type to a UTF-8 string of `char8_t`.
+    ///
+    /// \param s Input string
+    /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+    ///
+    template<typename StringOrStringView, typename = detail::requires_string_container<StringOrStringView>>
+    inline std::u8string to_u8string(const StringOrStringView& s)
+    {
+        return utf::convert_string<char8_t>(s.data(), s.data() + s.size());
+    }
+#endif
 } // namespace nowide
 } // namespace boost
 
@@ -83,11 +83,16 @@ namespace nowide {
         using requires_narrow_string_container = typename std::enable_if<is_string_container<T, true>::value>::type;
         template<typename T>
         using requires_wide_string_container = typename std::enable_if<is_string_container<T, false>::value>::type;
+        template<typename T>
+        using requires_string_container =
+          typename std::enable_if<is_string_container<T, true>::value || is_string_container<T, false>::value>::type;
 
         template<typename T>
         using requires_narrow_char = typename std::enable_if<sizeof(T) == 1 && is_char_type<T>::value>::type;
         template<typename T>
         using requires_wide_char = typename std::enable_if<(sizeof(T) > 1) && is_char_type<T>::value>::type;
+        template<typename T>
+        using requires_char = typename std::enable_if<is_char_type<T>::value>::type;
 
     } // namespace detail
 } // namespace nowide
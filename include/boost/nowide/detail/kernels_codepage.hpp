@@ -0,0 +1,327 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_KERNELS_CODEPAGE_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_KERNELS_CODEPAGE_HPP_INCLUDED
+
+#include <boost/nowide/detail/kernels_validate.hpp>
+#include <boost/nowide/detail/kernels_wide_to_utf8.hpp>
+#include <boost/nowide/detail/simd.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//! @cond Doxygen_Suppress
+
+// Kernels for the single byte codepages of utf/codepage.hpp:
+// Each byte is a code point, those below 0x80 are ASCII and those from `IdentityBegin` (0x80 for Latin-1,
+// 0xA0 for Windows-1252) up to 0xFF are the code points of the same value.
+// The kernels handle those bytes (or code points when encoding) only and stop at the first other one,
+// which is converted by the generic decoder & encoder using the table of the codepage.
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        /// Copy the ASCII prefix of [in, in_end) to [out, out_end) as far as it fits, for conversions
+        /// between single byte encodings (UTF-8 and the codepages) which all agree on ASCII
+        template<typename CharOut, typename CharIn>
+        inline void copy_ascii_prefix(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+        {
+            const CharIn* const end = (out_end - out < in_end - in) ? in + (out_end - out) : in_end;
+            const std::size_t n = static_cast<std::size_t>(ascii_prefix(in, end) - in);
+            if(n != 0)
+                std::memcpy(out, in, n);
+            in += n;
+            out += n;
+        }
+
+        /// Encode the n code units (code points up to 0xFF) at p as UTF-8 without branching on their values,
+        /// requires space for 2 * n bytes
+        template<typename CharIn>
+        inline void expand_latin1_units(const CharIn*& p, unsigned n, unsigned char*& o)
+        {
+            for(; n > 0; --n)
+            {
+                const unsigned c = static_cast<unsigned char>(*p++);
+                const unsigned is_two_bytes = c >> 7;
+                o[0] = static_cast<unsigned char>(is_two_bytes ? (0xC0 | (c >> 6)) : c);
+                o[1] = static_cast<unsigned char>(0x80 | (c & 0x3F));
+                o += 1 + is_two_bytes;
+            }
+        }
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+        namespace sse2 {
+            /// Return a 16 bit mask of the bytes in [0x80, IdentityBegin), i.e. which are not the same code point
+            template<unsigned IdentityBegin>
+            BOOST_NOWIDE_TARGET_SSE2 inline unsigned remapped_mask(const __m128i v)
+            {
+                if(IdentityBegin == 0x80)
+                    return 0;
+                // As signed values [0x80, IdentityBegin) are the smallest ones
+                return static_cast<unsigned>(
+                  _mm_movemask_epi8(_mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(IdentityBegin)))));
+            }
+
+            /// Zero-extend the 16 bytes of v to 16 code units of 2 or 4 bytes at o
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline void store_widened(const __m128i v, CharOut* o)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i lo = _mm_unpacklo_epi8(v, zero);
+                const __m128i hi = _mm_unpackhi_epi8(v, zero);
+                if(sizeof(CharOut) == 2)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), lo);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 8), hi);
+                } else
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_unpacklo_epi16(lo, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 4), _mm_unpackhi_epi16(lo, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 8), _mm_unpacklo_epi16(hi, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 12), _mm_unpackhi_epi16(hi, zero));
+                }
+            }
+
+            /// Pack 16 code units of 2 or 4 bytes at p to bytes, exact for the units up to 0xFF.
+            /// `above_byte` is set to a 16 bit mask of the other units
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i pack_units(const CharIn* p, unsigned& above_byte)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                __m128i fits, v;
+                if(sizeof(CharIn) == 2)
+                {
+                    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+                    fits = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_srli_epi16(a, 8), zero),
+                                           _mm_cmpeq_epi16(_mm_srli_epi16(b, 8), zero));
+                    v = _mm_packus_epi16(a, b);
+                } else
+                {
+                    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+                    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+                    const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+                    const __m128i fits_ab = _mm_packs_epi32(_mm_cmpeq_epi32(_mm_srli_epi32(a, 8), zero),
+                                                            _mm_cmpeq_epi32(_mm_srli_epi32(b, 8), zero));
+                    const __m128i fits_cd = _mm_packs_epi32(_mm_cmpeq_epi32(_mm_srli_epi32(c, 8), zero),
+                                                            _mm_cmpeq_epi32(_mm_srli_epi32(d, 8), zero));
+                    fits = _mm_packs_epi16(fits_ab, fits_cd);
+                    v = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                }
+                above_byte = ~static_cast<unsigned>(_mm_movemask_epi8(fits)) & 0xFFFFu;
+                return v;
+            }
+
+            /// Codepage -> UTF-16/32 by zero-extending the bytes, stops at the first remapped one
+            template<unsigned IdentityBegin, typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            codepage_to_wide(const unsigned char*& in, const unsigned char* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 16 && out_end - o >= 16)
+                {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    store_widened(v, o);
+                    const unsigned remapped = remapped_mask<IdentityBegin>(v);
+                    if(remapped != 0)
+                    {
+                        // The units stored after the remapped byte are overwritten later
+                        const unsigned n = count_trailing_zeros(remapped);
+                        p += n;
+                        o += n;
+                        break;
+                    }
+                    p += 16;
+                    o += 16;
+                }
+                in = p;
+                out = o;
+            }
+
+            /// UTF-16/32 -> codepage by packing the code units, stops at the first one not mapped to itself
+            template<unsigned IdentityBegin, typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            wide_to_codepage(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 16 && out_end - o >= 16)
+                {
+                    unsigned invalid;
+                    const __m128i v = pack_units(p, invalid);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), v);
+                    invalid |= remapped_mask<IdentityBegin>(v);
+                    if(invalid != 0)
+                    {
+                        const unsigned n = count_trailing_zeros(invalid);
+                        p += n;
+                        o += n;
+                        break;
+                    }
+                    p += 16;
+                    o += 16;
+                }
+                in = p;
+                out = o;
+            }
+
+            /// Convert one block starting at p, requires 16 readable bytes and space for 32 bytes.
+            /// Return false if the byte at p needs to be handled by the generic decoder
+            template<unsigned IdentityBegin>
+            BOOST_NOWIDE_TARGET_SSE2 inline bool codepage_to_utf8_step(const unsigned char*& p, unsigned char*& o)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const unsigned non_ascii = static_cast<unsigned>(_mm_movemask_epi8(v));
+                if(non_ascii == 0)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), v);
+                    p += 16;
+                    o += 16;
+                    return true;
+                }
+                const unsigned remapped = remapped_mask<IdentityBegin>(v);
+                if(remapped != 0)
+                {
+                    const unsigned n = count_trailing_zeros(remapped);
+                    expand_latin1_units(p, n, o);
+                    return n > 0;
+                }
+                if(non_ascii == 0xFFFF)
+                {
+                    const __m128i zero = _mm_setzero_si128();
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), encode_two_byte_block(_mm_unpacklo_epi8(v, zero)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 16),
+                                     encode_two_byte_block(_mm_unpackhi_epi8(v, zero)));
+                    p += 16;
+                    o += 32;
+                } else
+                    expand_latin1_units(p, 16, o);
+                return true;
+            }
+
+            template<unsigned IdentityBegin>
+            BOOST_NOWIDE_TARGET_SSE2 inline void codepage_to_utf8(const unsigned char*& in,
+                                                                  const unsigned char* in_end,
+                                                                  unsigned char*& out,
+                                                                  unsigned char* out_end)
+            {
+                const unsigned char* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 16 && out_end - o >= 32 && codepage_to_utf8_step<IdentityBegin>(p, o))
+                {}
+                in = p;
+                out = o;
+            }
+
+            /// Add the UTF-8 length of the codepage input to `length` up to the first remapped byte
+            template<unsigned IdentityBegin>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            codepage_utf8_length(const unsigned char*& in, const unsigned char* in_end, std::size_t& length)
+            {
+                const unsigned char* p = in;
+                std::size_t n = length;
+                while(in_end - p >= 16)
+                {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    const unsigned non_ascii = static_cast<unsigned>(_mm_movemask_epi8(v));
+                    const unsigned remapped = remapped_mask<IdentityBegin>(v);
+                    const unsigned num_units = (remapped == 0) ? 16 : count_trailing_zeros(remapped);
+                    n += num_units + count_bits(non_ascii & ((1u << num_units) - 1u));
+                    p += num_units;
+                    if(remapped != 0)
+                        break;
+                }
+                in = p;
+                length = n;
+            }
+        } // namespace sse2
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+        namespace avx2 {
+            /// Codepage -> UTF-16/32 by zero-extending the bytes, stops at the first remapped one
+            template<unsigned IdentityBegin, typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline void
+            codepage_to_wide(const unsigned char*& in, const unsigned char* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 16 && out_end - o >= 16)
+                {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    if(sizeof(CharOut) == 2)
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), _mm256_cvtepu8_epi16(v));
+                    else
+                    {
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), _mm256_cvtepu8_epi32(v));
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 8),
+                                            _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+                    }
+                    const unsigned remapped = sse2::remapped_mask<IdentityBegin>(v);
+                    if(remapped != 0)
+                    {
+                        const unsigned n = count_trailing_zeros(remapped);
+                        p += n;
+                        o += n;
+                        break;
+                    }
+                    p += 16;
+                    o += 16;
+                }
+                in = p;
+                out = o;
+            }
+
+            /// Convert 32 ASCII bytes at once or else 2 blocks of 16, requires 32 readable bytes and space for 64 bytes
+            template<unsigned IdentityBegin>
+            BOOST_NOWIDE_TARGET_AVX2 inline bool codepage_to_utf8_step256(const unsigned char*& p, unsigned char*& o)
+            {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                if(_mm256_movemask_epi8(v) == 0)
+                {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), v);
+                    p += 32;
+                    o += 32;
+                    return true;
+                }
+                return sse2::codepage_to_utf8_step<IdentityBegin>(p, o)
+                       && sse2::codepage_to_utf8_step<IdentityBegin>(p, o);
+            }
+
+            template<unsigned IdentityBegin>
+            BOOST_NOWIDE_TARGET_AVX2 inline void codepage_to_utf8(const unsigned char*& in,
+                                                                  const unsigned char* in_end,
+                                                                  unsigned char*& out,
+                                                                  unsigned char* out_end)
+            {
+                const unsigned char* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 32 && out_end - o >= 64)
+                {
+                    if(!codepage_to_utf8_step256<IdentityBegin>(p, o))
+                    {
+                        in = p;
+                        out = o;
+                        return;
+                    }
+                }
+                in = p;
+                out = o;
+                sse2::codepage_to_utf8<IdentityBegin>(in, in_end, out, out_end);
+            }
+        } // namespace avx2
+#endif
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
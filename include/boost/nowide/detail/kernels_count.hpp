@@ -0,0 +1,317 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_KERNELS_COUNT_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_KERNELS_COUNT_HPP_INCLUDED
+
+#include <boost/nowide/detail/kernels_swar.hpp>
+#include <boost/nowide/detail/simd.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+//! @cond Doxygen_Suppress
+
+// Count code points without decoding them:
+// In UTF-8 every byte except the continuation bytes (10xxxxxx) starts a code point,
+// in UTF-16 every unit except the low (trailing) surrogates (0xDC00-0xDFFF).
+// For the number of UTF-16 units of UTF-8 input the leads of 4 byte sequences (11110xxx) are counted twice.
+// The kernels count whole blocks only and advance the input past them, the caller handles the rest.
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+#ifdef BOOST_NOWIDE_SWAR
+        namespace swar {
+            /// Return the number of bytes in the word with the highest bit set
+            inline std::size_t count_high_bytes(const std::uint64_t bits)
+            {
+                return static_cast<std::size_t>(((bits >> 7) * 0x0101010101010101u) >> 56);
+            }
+
+            /// Number of UTF-16 (OutSize 2) or UTF-32 (OutSize 4) code units the UTF-8 in whole words converts to
+            template<int OutSize>
+            inline std::size_t count_utf8_units(const unsigned char*& p, const unsigned char* end)
+            {
+                const std::uint64_t high_bits = 0x8080808080808080u;
+                std::size_t count = 0;
+                for(; end - p >= 8; p += 8)
+                {
+                    const std::uint64_t w = load_word(p);
+                    // 10xxxxxx: Highest bit set, next one cleared
+                    count += 8 - count_high_bytes(w & ~(w << 1) & high_bits);
+                    if(OutSize == 2) // 1111xxxx
+                        count += count_high_bytes(w & (w << 1) & (w << 2) & (w << 3) & high_bits);
+                }
+                return count;
+            }
+
+            /// Number of UTF-16 code units in whole words which are not a low surrogate
+            inline std::size_t count_utf16_code_points(const unsigned char*& p, const unsigned char* end)
+            {
+                const std::uint64_t high_bits = 0x8000800080008000u;
+                const std::uint64_t low_bits = 0x7FFF7FFF7FFF7FFFu;
+                std::size_t count = 0;
+                for(; end - p >= 8; p += 8)
+                {
+                    // Units which are low surrogates become zero, the others get their highest bit set
+                    const std::uint64_t w = (load_word(p) & 0xFC00FC00FC00FC00u) ^ 0xDC00DC00DC00DC00u;
+                    const std::uint64_t non_zero = (((w & low_bits) + low_bits) | w) & high_bits;
+                    count += static_cast<std::size_t>(((non_zero >> 15) * 0x0001000100010001u) >> 48);
+                }
+                return count;
+            }
+        } // namespace swar
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+        namespace sse2 {
+            /// Return the sum of the unsigned bytes
+            BOOST_NOWIDE_TARGET_SSE2 inline std::size_t sum_bytes(const __m128i v)
+            {
+                const __m128i sums = _mm_sad_epu8(v, _mm_setzero_si128());
+                return static_cast<std::size_t>(_mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+            }
+
+            /// Same as swar::count_utf8_units with blocks of 16 bytes
+            template<int OutSize>
+            BOOST_NOWIDE_TARGET_SSE2 inline std::size_t count_utf8_units(const unsigned char*& p,
+                                                                         const unsigned char* end)
+            {
+                // Signed comparison: Only the continuation bytes are at most 0xBF
+                const __m128i last_continuation = _mm_set1_epi8(static_cast<char>(0xBF));
+                const __m128i first_4_byte_lead = _mm_set1_epi8(static_cast<char>(0xF0));
+                std::size_t count = 0;
+                while(end - p >= 16)
+                {
+                    // Each block adds at most 2 to each byte of the counters
+                    __m128i counters = _mm_setzero_si128();
+                    for(int i = 0; i < 127 && end - p >= 16; i++, p += 16)
+                    {
+                        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                        counters = _mm_sub_epi8(counters, _mm_cmpgt_epi8(v, last_continuation));
+                        if(OutSize == 2)
+                            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(_mm_max_epu8(v, first_4_byte_lead), v));
+                    }
+                    count += sum_bytes(counters);
+                }
+                return count;
+            }
+
+            /// Same as swar::count_utf16_code_points with blocks of 16 bytes
+            BOOST_NOWIDE_TARGET_SSE2 inline std::size_t count_utf16_code_points(const unsigned char*& p,
+                                                                                const unsigned char* end)
+            {
+                const __m128i surrogate_bits = _mm_set1_epi16(static_cast<short>(0xFC00));
+                const __m128i low_surrogate = _mm_set1_epi16(static_cast<short>(0xDC00));
+                const unsigned char* const begin = p;
+                std::size_t num_low_surrogates = 0;
+                while(end - p >= 16)
+                {
+                    // Each block adds at most 1 to each 16 bit counter, keep them below 0x8000 for _mm_madd_epi16
+                    __m128i counters = _mm_setzero_si128();
+                    for(int i = 0; i < 0x7FFF && end - p >= 16; i++, p += 16)
+                    {
+                        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                        counters =
+                          _mm_sub_epi16(counters, _mm_cmpeq_epi16(_mm_and_si128(v, surrogate_bits), low_surrogate));
+                    }
+                    const __m128i sums = _mm_madd_epi16(counters, _mm_set1_epi16(1));
+                    const __m128i sums2 = _mm_add_epi32(sums, _mm_srli_si128(sums, 8));
+                    num_low_surrogates +=
+                      static_cast<std::size_t>(_mm_cvtsi128_si32(_mm_add_epi32(sums2, _mm_srli_si128(sums2, 4))));
+                }
+                return static_cast<std::size_t>(p - begin) / 2 - num_low_surrogates;
+            }
+        } // namespace sse2
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+        namespace avx2 {
+            /// Same as swar::count_utf8_units with blocks of 32 bytes
+            template<int OutSize>
+            BOOST_NOWIDE_TARGET_AVX2 inline std::size_t count_utf8_units(const unsigned char*& p,
+                                                                         const unsigned char* end)
+            {
+                const __m256i last_continuation = _mm256_set1_epi8(static_cast<char>(0xBF));
+                const __m256i first_4_byte_lead = _mm256_set1_epi8(static_cast<char>(0xF0));
+                std::size_t count = 0;
+                while(end - p >= 32)
+                {
+                    __m256i counters = _mm256_setzero_si256();
+                    for(int i = 0; i < 127 && end - p >= 32; i++, p += 32)
+                    {
+                        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                        counters = _mm256_sub_epi8(counters, _mm256_cmpgt_epi8(v, last_continuation));
+                        if(OutSize == 2)
+                        {
+                            counters =
+                              _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(_mm256_max_epu8(v, first_4_byte_lead), v));
+                        }
+                    }
+                    const __m256i sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+                    const __m128i sums2 =
+                      _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+                    count += static_cast<std::size_t>(_mm_cvtsi128_si32(sums2)
+                                                      + _mm_cvtsi128_si32(_mm_srli_si128(sums2, 8)));
+                }
+                return count + sse2::count_utf8_units<OutSize>(p, end);
+            }
+
+            /// Same as swar::count_utf16_code_points with blocks of 32 bytes
+            BOOST_NOWIDE_TARGET_AVX2 inline std::size_t count_utf16_code_points(const unsigned char*& p,
+                                                                                const unsigned char* end)
+            {
+                const __m256i surrogate_bits = _mm256_set1_epi16(static_cast<short>(0xFC00));
+                const __m256i low_surrogate = _mm256_set1_epi16(static_cast<short>(0xDC00));
+                const unsigned char* const begin = p;
+                std::size_t num_low_surrogates = 0;
+                while(end - p >= 32)
+                {
+                    __m256i counters = _mm256_setzero_si256();
+                    for(int i = 0; i < 0x7FFF && end - p >= 32; i++, p += 32)
+                    {
+                        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                        counters = _mm256_sub_epi16(
+                          counters, _mm256_cmpeq_epi16(_mm256_and_si256(v, surrogate_bits), low_surrogate));
+                    }
+                    const __m256i sums = _mm256_madd_epi16(counters, _mm256_set1_epi16(1));
+                    const __m128i sums2 =
+                      _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+                    const __m128i sums4 = _mm_add_epi32(sums2, _mm_srli_si128(sums2, 8));
+                    num_low_surrogates +=
+                      static_cast<std::size_t>(_mm_cvtsi128_si32(_mm_add_epi32(sums4, _mm_srli_si128(sums4, 4))));
+                }
+                return static_cast<std::size_t>(p - begin) / 2 - num_low_surrogates
+                       + sse2::count_utf16_code_points(p, end);
+            }
+        } // namespace avx2
+#endif
+
+        /// Count the UTF-16 (OutSize 2) or UTF-32 (OutSize 4) code units UTF-8 converts to, see swar::count_utf8_units
+        template<int OutSize>
+        struct utf8_count_kernels
+        {
+            using kernel = std::size_t (*)(const unsigned char*& p, const unsigned char* end);
+            static std::size_t scalar(const unsigned char*& p, const unsigned char* end)
+            {
+#ifdef BOOST_NOWIDE_SWAR
+                return swar::count_utf8_units<OutSize>(p, end);
+#else
+                (void)p;
+                (void)end;
+                return 0;
+#endif
+            }
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &avx2::count_utf8_units<OutSize>;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &sse2::count_utf8_units<OutSize>;
+#endif
+                (void)isa;
+                return &scalar;
+            }
+        };
+
+        /// Count the UTF-16 code units which are not low surrogates, see swar::count_utf16_code_points
+        struct utf16_count_kernels
+        {
+            using kernel = std::size_t (*)(const unsigned char*& p, const unsigned char* end);
+            static std::size_t scalar(const unsigned char*& p, const unsigned char* end)
+            {
+#ifdef BOOST_NOWIDE_SWAR
+                return swar::count_utf16_code_points(p, end);
+#else
+                (void)p;
+                (void)end;
+                return 0;
+#endif
+            }
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &avx2::count_utf16_code_points;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &sse2::count_utf16_code_points;
+#endif
+                (void)isa;
+                return &scalar;
+            }
+        };
+
+        /// Return the number of UTF-16 (OutSize 2) or UTF-32 (OutSize 4) code units the valid UTF-8 in [begin, end)
+        /// converts to. For invalid input this is only the number of non-continuation bytes
+        /// (plus the number of 4 byte leads for UTF-16).
+        template<int OutSize, typename CharIn>
+        std::size_t count_utf8_units(const CharIn* begin, const CharIn* end)
+        {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(begin);
+            const unsigned char* const e = reinterpret_cast<const unsigned char*>(end);
+            std::size_t count = active_kernel<utf8_count_kernels<OutSize>>()(p, e);
+            for(; p != e; ++p)
+            {
+                if((*p & 0xC0) != 0x80)
+                    ++count;
+                if(OutSize == 2 && *p >= 0xF0)
+                    ++count;
+            }
+            return count;
+        }
+
+        /// Return the number of code points in the valid UTF-16 in [begin, end).
+        /// For invalid input this is the number of code units which are not low surrogates.
+        template<typename CharIn>
+        std::size_t count_utf16_code_points(const CharIn* begin, const CharIn* end)
+        {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(begin);
+            std::size_t count =
+              active_kernel<utf16_count_kernels>()(p, reinterpret_cast<const unsigned char*>(end));
+            for(const CharIn* cur = reinterpret_cast<const CharIn*>(p); cur != end; ++cur)
+            {
+                if((static_cast<std::uint16_t>(*cur) & 0xFC00u) != 0xDC00u)
+                    ++count;
+            }
+            return count;
+        }
+
+        /// Return the number of code points in the valid UTF in [begin, end), see utf::count_codepoints
+        template<typename CharIn>
+        std::size_t count_code_points(const CharIn* begin, const CharIn* end, std::integral_constant<int, 1>)
+        {
+            return count_utf8_units<4>(begin, end);
+        }
+        template<typename CharIn>
+        std::size_t count_code_points(const CharIn* begin, const CharIn* end, std::integral_constant<int, 2>)
+        {
+            return count_utf16_code_points(begin, end);
+        }
+        template<typename CharIn>
+        std::size_t count_code_points(const CharIn* begin, const CharIn* end, std::integral_constant<int, 4>)
+        {
+            return static_cast<std::size_t>(end - begin);
+        }
+        /// Single byte codepages, see code_unit_size
+        template<typename CharIn>
+        std::size_t count_code_points(const CharIn* begin, const CharIn* end, std::integral_constant<int, 0>)
+        {
+            return static_cast<std::size_t>(end - begin);
+        }
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
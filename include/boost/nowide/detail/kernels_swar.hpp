@@ -0,0 +1,180 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_KERNELS_SWAR_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_KERNELS_SWAR_HPP_INCLUDED
+
+#include <boost/nowide/detail/kernels_utf8_to_wide.hpp>
+#include <boost/nowide/detail/kernels_wide_to_utf8.hpp>
+#include <boost/nowide/detail/simd.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <cstdint>
+#include <cstring>
+
+//! @cond Doxygen_Suppress
+
+// Portable kernels working on 64 bit words ("SIMD within a register"):
+// A word of code units is checked for non-ASCII units with a single mask test and copied as a whole if there are none.
+// As the mask is the same for every unit of a word the test does not depend on the byte order.
+
+#ifdef BOOST_NOWIDE_SWAR
+namespace boost {
+namespace nowide {
+    namespace detail {
+        namespace swar {
+            /// Load 8 bytes from an arbitrarily aligned address
+            inline std::uint64_t load_word(const void* p)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, p, sizeof(word));
+                return word;
+            }
+
+            /// Bits of a word which are set for non-ASCII code units of the given size
+            template<int Size>
+            struct non_ascii_bits;
+            template<>
+            struct non_ascii_bits<1>
+            {
+                static constexpr std::uint64_t value = 0x8080808080808080u;
+            };
+            template<>
+            struct non_ascii_bits<2>
+            {
+                static constexpr std::uint64_t value = 0xFF80FF80FF80FF80u;
+            };
+            template<>
+            struct non_ascii_bits<4>
+            {
+                static constexpr std::uint64_t value = 0xFFFFFF80FFFFFF80u;
+            };
+
+            /// Return true if all code units of the given size in the 8 bytes at p are ASCII
+            template<int Size>
+            inline bool is_ascii_word(const unsigned char* p)
+            {
+                return (load_word(p) & non_ascii_bits<Size>::value) == 0;
+            }
+
+            /// Return the end of an ASCII prefix of the code units of the given size in [begin, end),
+            /// checked in blocks of 16 and 8 bytes
+            template<int Size>
+            inline const unsigned char* find_non_ascii(const unsigned char* begin, const unsigned char* end)
+            {
+                const unsigned char* p = begin;
+                while(end - p >= 16 && ((load_word(p) | load_word(p + 8)) & non_ascii_bits<Size>::value) == 0)
+                    p += 16;
+                if(end - p >= 8 && is_ascii_word<Size>(p))
+                    p += 8;
+                return p;
+            }
+
+            template<typename CharOut>
+            inline void
+            utf8_to_wide(const unsigned char*& in, const unsigned char* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 8 && out_end - o >= 8)
+                {
+                    if(is_ascii_word<1>(p))
+                    {
+                        for(int i = 0; i < 8; i++)
+                            o[i] = static_cast<CharOut>(p[i]);
+                        p += 8;
+                        o += 8;
+                        continue;
+                    }
+                    // Stops within the word
+                    while(*p < 0x80)
+                        *o++ = static_cast<CharOut>(*p++);
+                    // Decode multi-byte sequences until the next ASCII byte
+                    utf::code_point c;
+                    unsigned len = 0;
+                    while(in_end - p >= 4 && *p >= 0x80 && out_end - o >= 2)
+                    {
+                        len = decode_utf8_multibyte(p, c);
+                        if(len == 0)
+                            break;
+                        p += len;
+                        o = utf::utf_traits<CharOut>::encode(c, o);
+                    }
+                    if(len == 0)
+                        break;
+                }
+                in = p;
+                out = o;
+            }
+
+            template<typename CharIn>
+            inline void
+            utf16_to_utf8(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                using utf16_traits = utf::utf_traits<CharIn, 2>;
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 4 && out_end - o >= 4)
+                {
+                    if(is_ascii_word<2>(reinterpret_cast<const unsigned char*>(p)))
+                    {
+                        for(int i = 0; i < 4; i++)
+                            o[i] = static_cast<unsigned char>(p[i]);
+                        p += 4;
+                        o += 4;
+                        continue;
+                    }
+                    // Encode the units of this word, a surrogate pair may extend into the next one
+                    const CharIn* const word_end = p + 4;
+                    while(p < word_end && out_end - o >= 4)
+                    {
+                        const std::uint16_t w1 = static_cast<std::uint16_t>(*p);
+                        if(utf16_traits::is_single_codepoint(w1))
+                        {
+                            o = utf8_encoder::encode(w1, o);
+                            ++p;
+                        } else if(in_end - p < 2 || !encode_utf16_surrogate_pair(p, o))
+                        {
+                            in = p;
+                            out = o;
+                            return;
+                        }
+                    }
+                }
+                in = p;
+                out = o;
+            }
+
+            template<typename CharIn>
+            inline void
+            utf32_to_utf8(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 4 && out_end - o >= 16)
+                {
+                    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(p);
+                    if(((load_word(bytes) | load_word(bytes + 8)) & non_ascii_bits<4>::value) == 0)
+                    {
+                        for(int i = 0; i < 4; i++)
+                            o[i] = static_cast<unsigned char>(p[i]);
+                        p += 4;
+                        o += 4;
+                    } else if(!encode_utf32_units(p, 4, o))
+                        break;
+                }
+                in = p;
+                out = o;
+            }
+        } // namespace swar
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+#endif
+
+//! @endcond
+
+#endif
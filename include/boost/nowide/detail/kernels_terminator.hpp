@@ -0,0 +1,297 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_KERNELS_TERMINATOR_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_KERNELS_TERMINATOR_HPP_INCLUDED
+
+#include <boost/nowide/detail/simd.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+//! @cond Doxygen_Suppress
+
+// Search for the NULL terminating a string of unknown length.
+// The vectorized and word-at-a-time kernels only use aligned loads: An aligned block never crosses a page boundary,
+// so it is readable if any of its bytes belongs to the string, even if it extends past the terminator.
+// Code units of 2 or 4 bytes are expected to be aligned to their size.
+// Strings of single bytes are measured using the (highly optimized) std::strlen.
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+#ifdef BOOST_NOWIDE_SWAR
+        namespace swar {
+#if defined(__GNUC__) || defined(__clang__)
+            /// 64 bit word which may be used to access objects of any type
+            typedef std::uint64_t __attribute__((__may_alias__)) aliased_word;
+#else
+            typedef std::uint64_t aliased_word;
+#endif
+            /// Lowest and highest bit of each code unit of the given size in a word
+            template<int Size>
+            struct unit_bits;
+            template<>
+            struct unit_bits<1>
+            {
+                static constexpr std::uint64_t low = 0x0101010101010101u;
+                static constexpr std::uint64_t high = 0x8080808080808080u;
+            };
+            template<>
+            struct unit_bits<2>
+            {
+                static constexpr std::uint64_t low = 0x0001000100010001u;
+                static constexpr std::uint64_t high = 0x8000800080008000u;
+            };
+            template<>
+            struct unit_bits<4>
+            {
+                static constexpr std::uint64_t low = 0x0000000100000001u;
+                static constexpr std::uint64_t high = 0x8000000080000000u;
+            };
+
+            /// Return true if any code unit of the given size in the word is zero
+            template<int Size>
+            inline bool has_zero_unit(const std::uint64_t word)
+            {
+                return ((word - unit_bits<Size>::low) & ~word & unit_bits<Size>::high) != 0;
+            }
+
+            /// Same as sse2::find_terminator using aligned 8 byte words.
+            /// The code units outside of the words are accessed as the character type of the string, Char.
+            template<typename Char>
+            BOOST_NOWIDE_NO_SANITIZE_ADDRESS inline const unsigned char* find_terminator(const unsigned char* p,
+                                                                                         const unsigned char* limit)
+            {
+                const Char* cur = reinterpret_cast<const Char*>(p);
+                for(; reinterpret_cast<std::uintptr_t>(cur) % 8u != 0; ++cur)
+                {
+                    if(reinterpret_cast<const unsigned char*>(cur) >= limit || *cur == 0)
+                        return reinterpret_cast<const unsigned char*>(cur);
+                }
+                const aliased_word* word = reinterpret_cast<const aliased_word*>(cur);
+                while(reinterpret_cast<const unsigned char*>(word) < limit && !has_zero_unit<sizeof(Char)>(*word))
+                    ++word;
+                cur = reinterpret_cast<const Char*>(word);
+                if(reinterpret_cast<const unsigned char*>(cur) < limit)
+                {
+                    while(*cur != 0)
+                        ++cur;
+                }
+                return reinterpret_cast<const unsigned char*>(cur);
+            }
+        } // namespace swar
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+        namespace sse2 {
+            /// Set all bytes of the code units of the given size which are NULL
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i zero_units(const __m128i v, std::integral_constant<int, 1>)
+            {
+                return _mm_cmpeq_epi8(v, _mm_setzero_si128());
+            }
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i zero_units(const __m128i v, std::integral_constant<int, 2>)
+            {
+                return _mm_cmpeq_epi16(v, _mm_setzero_si128());
+            }
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i zero_units(const __m128i v, std::integral_constant<int, 4>)
+            {
+                return _mm_cmpeq_epi32(v, _mm_setzero_si128());
+            }
+            /// Return a mask with the bits of all bytes set which belong to a NULL code unit of the given size
+            /// in the aligned block
+            template<int Size>
+            BOOST_NOWIDE_TARGET_SSE2 BOOST_NOWIDE_NO_SANITIZE_ADDRESS inline unsigned
+            zero_unit_mask(const unsigned char* block)
+            {
+                const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+                return static_cast<unsigned>(_mm_movemask_epi8(zero_units(v, std::integral_constant<int, Size>())));
+            }
+
+            /// Return the first NULL code unit of the given size at or after p
+            /// or, if there is none before it, the first 16 byte boundary at or after limit
+            template<int Size>
+            BOOST_NOWIDE_TARGET_SSE2 BOOST_NOWIDE_NO_SANITIZE_ADDRESS inline const unsigned char*
+            find_terminator(const unsigned char* p, const unsigned char* limit)
+            {
+                const std::integral_constant<int, Size> size;
+                const unsigned offset = static_cast<unsigned>(reinterpret_cast<std::uintptr_t>(p) % 16u);
+                const unsigned char* block = p - offset;
+                // Ignore the bytes before p
+                unsigned mask = zero_unit_mask<Size>(block) >> offset << offset;
+                while(mask == 0)
+                {
+                    block += 16;
+                    if(block >= limit)
+                        return block;
+                    // Continue with 64 bytes at once, aligned so they are on the same page
+                    if(reinterpret_cast<std::uintptr_t>(block) % 64u == 0)
+                    {
+                        while(true)
+                        {
+                            const __m128i* const blocks = reinterpret_cast<const __m128i*>(block);
+                            const __m128i a = zero_units(_mm_load_si128(blocks), size);
+                            const __m128i b = zero_units(_mm_load_si128(blocks + 1), size);
+                            const __m128i c = zero_units(_mm_load_si128(blocks + 2), size);
+                            const __m128i d = zero_units(_mm_load_si128(blocks + 3), size);
+                            if(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) != 0)
+                                break;
+                            block += 64;
+                            if(block >= limit)
+                                return block;
+                        }
+                        while((mask = zero_unit_mask<Size>(block)) == 0)
+                            block += 16;
+                        break;
+                    }
+                    mask = zero_unit_mask<Size>(block);
+                }
+                return block + count_trailing_zeros(mask);
+            }
+        } // namespace sse2
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+        namespace avx2 {
+            BOOST_NOWIDE_TARGET_AVX2 inline __m256i zero_units(const __m256i v, std::integral_constant<int, 1>)
+            {
+                return _mm256_cmpeq_epi8(v, _mm256_setzero_si256());
+            }
+            BOOST_NOWIDE_TARGET_AVX2 inline __m256i zero_units(const __m256i v, std::integral_constant<int, 2>)
+            {
+                return _mm256_cmpeq_epi16(v, _mm256_setzero_si256());
+            }
+            BOOST_NOWIDE_TARGET_AVX2 inline __m256i zero_units(const __m256i v, std::integral_constant<int, 4>)
+            {
+                return _mm256_cmpeq_epi32(v, _mm256_setzero_si256());
+            }
+            template<int Size>
+            BOOST_NOWIDE_TARGET_AVX2 BOOST_NOWIDE_NO_SANITIZE_ADDRESS inline unsigned
+            zero_unit_mask(const unsigned char* block)
+            {
+                const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+                return static_cast<unsigned>(_mm256_movemask_epi8(zero_units(v, std::integral_constant<int, Size>())));
+            }
+
+            /// Same as sse2::find_terminator with blocks of 32 bytes
+            template<int Size>
+            BOOST_NOWIDE_TARGET_AVX2 BOOST_NOWIDE_NO_SANITIZE_ADDRESS inline const unsigned char*
+            find_terminator(const unsigned char* p, const unsigned char* limit)
+            {
+                const std::integral_constant<int, Size> size;
+                const unsigned offset = static_cast<unsigned>(reinterpret_cast<std::uintptr_t>(p) % 32u);
+                const unsigned char* block = p - offset;
+                unsigned mask = zero_unit_mask<Size>(block) >> offset << offset;
+                while(mask == 0)
+                {
+                    block += 32;
+                    if(block >= limit)
+                        return block;
+                    if(reinterpret_cast<std::uintptr_t>(block) % 64u == 0)
+                    {
+                        while(true)
+                        {
+                            const __m256i* const blocks = reinterpret_cast<const __m256i*>(block);
+                            const __m256i a = zero_units(_mm256_load_si256(blocks), size);
+                            const __m256i b = zero_units(_mm256_load_si256(blocks + 1), size);
+                            if(_mm256_movemask_epi8(_mm256_or_si256(a, b)) != 0)
+                                break;
+                            block += 64;
+                            if(block >= limit)
+                                return block;
+                        }
+                        if((mask = zero_unit_mask<Size>(block)) == 0)
+                            mask = zero_unit_mask<Size>(block += 32);
+                        break;
+                    }
+                    mask = zero_unit_mask<Size>(block);
+                }
+                return block + count_trailing_zeros(mask);
+            }
+        } // namespace avx2
+#endif
+
+        /// Find the first NULL code unit of a string of Char at or after p, see sse2::find_terminator
+        template<typename Char>
+        struct terminator_kernels
+        {
+            static constexpr int size = sizeof(Char);
+            using kernel = const unsigned char* (*)(const unsigned char* p, const unsigned char* limit);
+
+            static const unsigned char* per_unit(const unsigned char* p, const unsigned char* limit)
+            {
+                const Char* cur = reinterpret_cast<const Char*>(p);
+                while(reinterpret_cast<const unsigned char*>(cur) < limit && *cur != 0)
+                    ++cur;
+                return reinterpret_cast<const unsigned char*>(cur);
+            }
+            static const unsigned char* scalar(const unsigned char* p, const unsigned char* limit)
+            {
+#ifdef BOOST_NOWIDE_SWAR
+                return swar::find_terminator<Char>(p, limit);
+#else
+                return per_unit(p, limit);
+#endif
+            }
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &avx2::find_terminator<size>;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &sse2::find_terminator<size>;
+#endif
+                (void)isa;
+                return &scalar;
+            }
+        };
+
+        /// Return the NULL terminating the string at \a p if it is within the next \a max_units code units
+        /// (or a bit further), else a position after those units before which there is no NULL
+        template<typename Char>
+        const Char* find_terminator(const Char* p, std::size_t max_units)
+        {
+            const unsigned char* const bytes = reinterpret_cast<const unsigned char*>(p);
+            const unsigned char* const limit = bytes + max_units * sizeof(Char);
+            // Blocks could start within a misaligned code unit
+            const unsigned char* const result =
+              (reinterpret_cast<std::uintptr_t>(p) % sizeof(Char) == 0)
+                ? active_kernel<terminator_kernels<Char>>()(bytes, limit)
+                : terminator_kernels<Char>::per_unit(bytes, limit);
+            return reinterpret_cast<const Char*>(result);
+        }
+
+        /// Return the length of the NULL terminated string \a s in code units
+        template<typename Char>
+        std::size_t string_length(const Char* s, std::integral_constant<std::size_t, 1> /*unit size*/)
+        {
+            return std::strlen(reinterpret_cast<const char*>(s));
+        }
+        template<typename Char, std::size_t Size>
+        std::size_t string_length(const Char* s, std::integral_constant<std::size_t, Size> /*unit size*/)
+        {
+            const Char* end = s;
+            // Large steps make the overhead of checking the limit negligible
+            while(*(end = find_terminator(end, 64 * 1024)) != 0)
+            {}
+            return static_cast<std::size_t>(end - s);
+        }
+        template<typename Char>
+        std::size_t string_length(const Char* s)
+        {
+            return string_length(s, std::integral_constant<std::size_t, sizeof(Char)>());
+        }
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
@@ -0,0 +1,275 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_KERNELS_UTF16_UTF32_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_KERNELS_UTF16_UTF32_HPP_INCLUDED
+
+#include <boost/nowide/detail/kernels_wide_to_utf8.hpp>
+#include <boost/nowide/detail/simd.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <cstddef>
+#include <cstdint>
+
+//! @cond Doxygen_Suppress
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        /// Convert the UTF-16 code units in [p, end) up to the first invalid one, a surrogate pair is only converted
+        /// if both units are in the range. Requires space for end - p units.
+        /// Return false if no unit was converted
+        template<typename CharIn, typename CharOut>
+        inline bool utf16_to_utf32_units(const CharIn*& p, const CharIn* const end, CharOut*& o)
+        {
+            using utf16_traits = utf::utf_traits<CharIn, 2>;
+            const CharIn* const begin = p;
+            while(p != end)
+            {
+                const std::uint16_t w1 = static_cast<std::uint16_t>(*p);
+                if(utf16_traits::is_single_codepoint(w1))
+                {
+                    *o++ = static_cast<CharOut>(w1);
+                    ++p;
+                } else if(end - p >= 2 && utf16_traits::is_first_surrogate(w1)
+                          && utf16_traits::is_second_surrogate(static_cast<std::uint16_t>(p[1])))
+                {
+                    *o++ = static_cast<CharOut>(utf16_traits::combine_surrogate(w1, static_cast<std::uint16_t>(p[1])));
+                    p += 2;
+                } else
+                    break;
+            }
+            return p != begin;
+        }
+
+        /// Convert the UTF-32 code units in [p, end) up to the first invalid one or until the output is full.
+        /// Return false if no unit was converted
+        template<typename CharIn, typename CharOut>
+        inline bool utf32_to_utf16_units(const CharIn*& p, const CharIn* const end, CharOut*& o, CharOut* const o_end)
+        {
+            const CharIn* const begin = p;
+            for(; p != end && o != o_end; ++p)
+            {
+                const utf::code_point c = static_cast<utf::code_point>(*p);
+                if(!utf::is_valid_codepoint(c))
+                    break;
+                if(c >= 0x10000)
+                {
+                    if(o_end - o < 2)
+                        break;
+                    o = utf::utf_traits<CharOut, 2>::encode(c, o);
+                } else
+                    *o++ = static_cast<CharOut>(c);
+            }
+            return p != begin;
+        }
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+        namespace sse2 {
+            /// Return a 16 bit mask (2 bits per unit) of the surrogates in 8 UTF-16 code units
+            BOOST_NOWIDE_TARGET_SSE2 inline unsigned surrogate_mask(const __m128i v)
+            {
+                const __m128i high_bits = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800)));
+                return static_cast<unsigned>(
+                  _mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, _mm_set1_epi16(static_cast<short>(0xD800)))));
+            }
+
+            /// Convert one block starting at p, requires 8 readable units and space for 8 units.
+            /// Return false if the unit at p needs to be handled by the generic decoder
+            template<typename CharIn, typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline bool utf16_to_utf32_step(const CharIn*& p, CharOut*& o)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if(surrogate_mask(v) != 0)
+                    return utf16_to_utf32_units(p, p + 8, o);
+                const __m128i zero = _mm_setzero_si128();
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_unpacklo_epi16(v, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 4), _mm_unpackhi_epi16(v, zero));
+                p += 8;
+                o += 8;
+                return true;
+            }
+
+            /// Convert one block starting at p, requires 8 readable units and space for 8 units.
+            /// Return false if the unit at p needs to be handled by the generic decoder
+            template<typename CharIn, typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline bool utf32_to_utf16_step(const CharIn*& p, CharOut*& o, CharOut* o_end)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+                if(is_bmp_block(a, b))
+                {
+                    const __m128i v = pack_bmp_block(a, b);
+                    if(surrogate_mask(v) == 0)
+                    {
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(o), v);
+                        p += 8;
+                        o += 8;
+                        return true;
+                    }
+                }
+                return utf32_to_utf16_units(p, p + 8, o, o_end);
+            }
+
+            template<typename CharIn, typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf16_to_utf32(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const CharIn* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 8 && out_end - o >= 8 && utf16_to_utf32_step(p, o))
+                {}
+                in = p;
+                out = o;
+            }
+
+            template<typename CharIn, typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf32_to_utf16(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const CharIn* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 8 && out_end - o >= 8 && utf32_to_utf16_step(p, o, out_end))
+                {}
+                in = p;
+                out = o;
+            }
+
+            /// Add the UTF-32 length of the UTF-16 input to `length` up to the first surrogate
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf16_utf32_length(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                const CharIn* p = in;
+                while(in_end - p >= 8)
+                {
+                    const unsigned surrogates = surrogate_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+                    if(surrogates != 0)
+                    {
+                        p += count_trailing_zeros(surrogates) / 2;
+                        break;
+                    }
+                    p += 8;
+                }
+                length += static_cast<std::size_t>(p - in);
+                in = p;
+            }
+
+            /// Add the UTF-16 length of the UTF-32 input to `length` up to the first invalid code point
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf32_utf16_length(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                const CharIn* p = in;
+                std::size_t n = length;
+                while(in_end - p >= 4)
+                {
+                    const __m128i c =
+                      _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), biased_epu32(0));
+                    const unsigned invalid =
+                      greater_mask(c, 0x10FFFF) | (greater_mask(c, 0xD7FF) & ~greater_mask(c, 0xDFFF));
+                    const unsigned num_units = (invalid == 0) ? 4 : count_trailing_zeros(invalid);
+                    n += num_units + count_bits(greater_mask(c, 0xFFFF) & ((1u << num_units) - 1u));
+                    p += num_units;
+                    if(invalid != 0)
+                        break;
+                }
+                in = p;
+                length = n;
+            }
+        } // namespace sse2
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+        namespace avx2 {
+            /// Convert 16 UTF-16 code units without surrogates at once,
+            /// requires 16 readable units and space for 16 units
+            template<typename CharIn, typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline bool utf16_to_utf32_step256(const CharIn*& p, CharOut*& o)
+            {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                const __m256i high_bits = _mm256_and_si256(v, _mm256_set1_epi16(static_cast<short>(0xF800)));
+                if(_mm256_movemask_epi8(_mm256_cmpeq_epi16(high_bits, _mm256_set1_epi16(static_cast<short>(0xD800))))
+                   != 0)
+                    return false;
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 8),
+                                    _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)));
+                p += 16;
+                o += 16;
+                return true;
+            }
+
+            /// Convert 16 UTF-32 code units in the BMP at once, requires 16 readable units and space for 16 units
+            template<typename CharIn, typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline bool utf32_to_utf16_step256(const CharIn*& p, CharOut*& o)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8));
+                const __m256i high = _mm256_or_si256(_mm256_srli_epi32(a, 16), _mm256_srli_epi32(b, 16));
+                if(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(high, _mm256_setzero_si256())))
+                   != 0xFFFFFFFFu)
+                    return false;
+                // Packing works per 128 bit lane, restore the order afterwards
+                const __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+                const __m256i high_bits = _mm256_and_si256(v, _mm256_set1_epi16(static_cast<short>(0xF800)));
+                if(_mm256_movemask_epi8(_mm256_cmpeq_epi16(high_bits, _mm256_set1_epi16(static_cast<short>(0xD800))))
+                   != 0)
+                    return false;
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), v);
+                p += 16;
+                o += 16;
+                return true;
+            }
+
+            template<typename CharIn, typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline void
+            utf16_to_utf32(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const CharIn* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 16 && out_end - o >= 16)
+                {
+                    if(!utf16_to_utf32_step256(p, o) && !sse2::utf16_to_utf32_step(p, o))
+                    {
+                        in = p;
+                        out = o;
+                        return;
+                    }
+                }
+                in = p;
+                out = o;
+                sse2::utf16_to_utf32(in, in_end, out, out_end);
+            }
+
+            template<typename CharIn, typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline void
+            utf32_to_utf16(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const CharIn* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 16 && out_end - o >= 16)
+                {
+                    if(!utf32_to_utf16_step256(p, o) && !sse2::utf32_to_utf16_step(p, o, out_end))
+                    {
+                        in = p;
+                        out = o;
+                        return;
+                    }
+                }
+                in = p;
+                out = o;
+                sse2::utf32_to_utf16(in, in_end, out, out_end);
+            }
+        } // namespace avx2
+#endif
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
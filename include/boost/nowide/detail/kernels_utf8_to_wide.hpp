@@ -0,0 +1,303 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_KERNELS_UTF8_TO_WIDE_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_KERNELS_UTF8_TO_WIDE_HPP_INCLUDED
+
+#include <boost/nowide/detail/simd.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <type_traits>
+
+//! @cond Doxygen_Suppress
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        /// Decode the UTF-8 sequence at p if it is valid.
+        /// Requires at least 4 readable bytes.
+        /// Return the number of bytes consumed or 0 if the sequence is invalid (or p points to ASCII)
+        inline unsigned decode_utf8_multibyte(const unsigned char* p, utf::code_point& c)
+        {
+            const unsigned lead = p[0];
+            if(lead < 0xC2)
+                return 0;
+            if((p[1] & 0xC0) != 0x80)
+                return 0;
+            if(lead < 0xE0)
+            {
+                c = ((lead & 0x1Fu) << 6) | (p[1] & 0x3Fu);
+                return 2;
+            }
+            if((p[2] & 0xC0) != 0x80)
+                return 0;
+            if(lead < 0xF0)
+            {
+                c = ((lead & 0x0Fu) << 12) | ((p[1] & 0x3Fu) << 6) | (p[2] & 0x3Fu);
+                // Overlong or surrogate
+                if(c < 0x800 || (c & 0xF800u) == 0xD800u)
+                    return 0;
+                return 3;
+            }
+            if(lead > 0xF4 || (p[3] & 0xC0) != 0x80)
+                return 0;
+            c = ((lead & 0x07u) << 18) | ((p[1] & 0x3Fu) << 12) | ((p[2] & 0x3Fu) << 6) | (p[3] & 0x3Fu);
+            if(c < 0x10000 || c > 0x10FFFF)
+                return 0;
+            return 4;
+        }
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+        namespace sse2 {
+            /// Store 8 code units given as 16 bit lanes to the UTF-16 output
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            store_units(CharOut* o, const __m128i units, std::integral_constant<int, 2>)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), units);
+            }
+            /// Store 8 code units given as 16 bit lanes to the UTF-32 output
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            store_units(CharOut* o, const __m128i units, std::integral_constant<int, 4>)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_unpacklo_epi16(units, _mm_setzero_si128()));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 4), _mm_unpackhi_epi16(units, _mm_setzero_si128()));
+            }
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline void store_units(CharOut* o, const __m128i units)
+            {
+                store_units(o, units, std::integral_constant<int, sizeof(CharOut)>());
+            }
+
+            /// Decode 16 bytes consisting of 8 2-byte sequences into 8 UTF-16 code units
+            BOOST_NOWIDE_TARGET_SSE2 inline bool decode_two_byte_block(const __m128i v, __m128i& units)
+            {
+                // Little endian: lead byte is the low byte of each 16 bit lane
+                const __m128i structure = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xC0E0))),
+                                                          _mm_set1_epi16(static_cast<short>(0x80C0)));
+                // Lead bytes 0xC0 and 0xC1 are overlong encodings
+                const __m128i overlong = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(0x1E)), _mm_setzero_si128());
+                if(_mm_movemask_epi8(_mm_andnot_si128(overlong, structure)) != 0xFFFF)
+                    return false;
+                units = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x1F)), 6),
+                                     _mm_srli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x3F00)), 8));
+                return true;
+            }
+
+            /// Convert one block starting at p to UTF-16 or UTF-32,
+            /// requires 16 readable bytes and space for 16 code units.
+            /// Return false if the sequence at p needs to be handled by the generic decoder
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline bool utf8_to_wide_step(const unsigned char*& p, CharOut*& o)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(v));
+                if(mask == 0)
+                {
+                    store_units(o, _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+                    store_units(o + 8, _mm_unpackhi_epi8(v, _mm_setzero_si128()));
+                    p += 16;
+                    o += 16;
+                    return true;
+                }
+                if((mask & 1u) == 0)
+                {
+                    // Copy the ASCII prefix only to not write past the end of the converted output
+                    for(unsigned n = count_trailing_zeros(mask); n > 0; --n)
+                        *o++ = static_cast<CharOut>(*p++);
+                    return true;
+                }
+                __m128i units;
+                if(decode_two_byte_block(v, units))
+                {
+                    store_units(o, units);
+                    p += 16;
+                    o += 8;
+                    return true;
+                }
+                utf::code_point c;
+                const unsigned len = decode_utf8_multibyte(p, c);
+                if(!len)
+                    return false;
+                p += len;
+                o = utf::utf_traits<CharOut>::encode(c, o);
+                return true;
+            }
+
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf8_to_wide(const unsigned char*& in, const unsigned char* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 16 && out_end - o >= 16 && utf8_to_wide_step(p, o))
+                {}
+                in = p;
+                out = o;
+            }
+        } // namespace sse2
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+        namespace sse41 {
+            /// Decode 12 bytes (of the 16 in v) consisting of 4 3-byte sequences into 4 code points (32 bit each)
+            BOOST_NOWIDE_TARGET_SSE41 inline bool decode_three_byte_block(const __m128i v, __m128i& code_points)
+            {
+                // Gather each sequence into a 32 bit lane: lead | trail1 << 8 | trail2 << 16
+                const __m128i t =
+                  _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+                const __m128i structure =
+                  _mm_cmpeq_epi32(_mm_and_si128(t, _mm_set1_epi32(0x00C0C0F0)), _mm_set1_epi32(0x008080E0));
+                const __m128i c =
+                  _mm_or_si128(_mm_slli_epi32(_mm_and_si128(t, _mm_set1_epi32(0x0F)), 12),
+                               _mm_or_si128(_mm_srli_epi32(_mm_and_si128(t, _mm_set1_epi32(0x3F00)), 2),
+                                            _mm_srli_epi32(_mm_and_si128(t, _mm_set1_epi32(0x3F0000)), 16)));
+                const __m128i overlong = _mm_cmplt_epi32(c, _mm_set1_epi32(0x800));
+                const __m128i surrogate =
+                  _mm_cmpeq_epi32(_mm_and_si128(c, _mm_set1_epi32(0xF800)), _mm_set1_epi32(0xD800));
+                if(_mm_movemask_epi8(_mm_andnot_si128(_mm_or_si128(overlong, surrogate), structure)) != 0xFFFF)
+                    return false;
+                code_points = c;
+                return true;
+            }
+
+            /// Store 4 code points given as 32 bit lanes to the UTF-16 output
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE41 inline void
+            store_code_points(CharOut* o, const __m128i code_points, std::integral_constant<int, 2>)
+            {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(o), _mm_packus_epi32(code_points, code_points));
+            }
+            /// Store 4 code points given as 32 bit lanes to the UTF-32 output
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE41 inline void
+            store_code_points(CharOut* o, const __m128i code_points, std::integral_constant<int, 4>)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), code_points);
+            }
+
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE41 inline bool utf8_to_wide_step(const unsigned char*& p, CharOut*& o)
+            {
+                __m128i code_points;
+                if((*p & 0xF0) == 0xE0
+                   && decode_three_byte_block(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), code_points))
+                {
+                    store_code_points(o, code_points, std::integral_constant<int, sizeof(CharOut)>());
+                    p += 12;
+                    o += 4;
+                    return true;
+                }
+                return sse2::utf8_to_wide_step(p, o);
+            }
+
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_SSE41 inline void
+            utf8_to_wide(const unsigned char*& in, const unsigned char* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 16 && out_end - o >= 16 && utf8_to_wide_step(p, o))
+                {}
+                in = p;
+                out = o;
+            }
+        } // namespace sse41
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+        namespace avx2 {
+            /// Store 16 code units given as 16 bit lanes to the UTF-16 output
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline void
+            store_units(CharOut* o, const __m256i units, std::integral_constant<int, 2>)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), units);
+            }
+            /// Store 16 code units given as 16 bit lanes to the UTF-32 output
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline void
+            store_units(CharOut* o, const __m256i units, std::integral_constant<int, 4>)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o),
+                                    _mm256_cvtepu16_epi32(_mm256_castsi256_si128(units)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 8),
+                                    _mm256_cvtepu16_epi32(_mm256_extracti128_si256(units, 1)));
+            }
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline void store_units(CharOut* o, const __m256i units)
+            {
+                store_units(o, units, std::integral_constant<int, sizeof(CharOut)>());
+            }
+
+            BOOST_NOWIDE_TARGET_AVX2 inline bool decode_two_byte_block(const __m256i v, __m256i& units)
+            {
+                const __m256i structure =
+                  _mm256_cmpeq_epi16(_mm256_and_si256(v, _mm256_set1_epi16(static_cast<short>(0xC0E0))),
+                                     _mm256_set1_epi16(static_cast<short>(0x80C0)));
+                const __m256i overlong =
+                  _mm256_cmpeq_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x1E)), _mm256_setzero_si256());
+                if(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_andnot_si256(overlong, structure))) != 0xFFFFFFFFu)
+                    return false;
+                units = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x1F)), 6),
+                                        _mm256_srli_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x3F00)), 8));
+                return true;
+            }
+
+            /// Convert 32 bytes at once if they are ASCII or 2-byte sequences only,
+            /// requires 32 readable bytes and space for 32 code units
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline bool utf8_to_wide_step256(const unsigned char*& p, CharOut*& o)
+            {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                if(_mm256_movemask_epi8(v) == 0)
+                {
+                    store_units(o, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+                    store_units(o + 16, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+                    p += 32;
+                    o += 32;
+                    return true;
+                }
+                __m256i units;
+                if(decode_two_byte_block(v, units))
+                {
+                    store_units(o, units);
+                    p += 32;
+                    o += 16;
+                    return true;
+                }
+                return false;
+            }
+
+            template<typename CharOut>
+            BOOST_NOWIDE_TARGET_AVX2 inline void
+            utf8_to_wide(const unsigned char*& in, const unsigned char* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = in;
+                CharOut* o = out;
+                while(in_end - p >= 32 && out_end - o >= 32)
+                {
+                    if(!utf8_to_wide_step256(p, o) && !sse41::utf8_to_wide_step(p, o))
+                    {
+                        in = p;
+                        out = o;
+                        return;
+                    }
+                }
+                in = p;
+                out = o;
+                sse41::utf8_to_wide(in, in_end, out, out_end);
+            }
+        } // namespace avx2
+#endif
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
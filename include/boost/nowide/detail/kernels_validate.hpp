@@ -0,0 +1,387 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_KERNELS_VALIDATE_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_KERNELS_VALIDATE_HPP_INCLUDED
+
+#include <boost/nowide/detail/kernels_swar.hpp>
+#include <boost/nowide/detail/simd.hpp>
+#include <type_traits>
+
+//! @cond Doxygen_Suppress
+
+// UTF-8 validation using lookup tables indexed by the nibbles of each byte and its predecessor,
+// see "Validating UTF-8 In Less Than One Instruction Per Byte" by John Keiser and Daniel Lemire.
+// Each table entry is a set of error classes possible for this nibble,
+// so a byte pair is invalid iff the intersection of its 3 entries is not empty.
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        namespace utf8_validation {
+            static const char too_short = 1 << 0;  // 11______ 0_______ or 11______ 11______
+            static const char too_long = 1 << 1;   // 0_______ 10______
+            static const char overlong_3 = 1 << 2; // 11100000 100_____
+            static const char too_large = 1 << 3;  // 11110100 1001____ or higher
+            static const char surrogate = 1 << 4;  // 11101101 101_____
+            static const char overlong_2 = 1 << 5; // 1100000_ 10______
+            static const char too_large_1000 = 1 << 6; // 11110101 1000____ or higher
+            static const char overlong_4 = 1 << 6;      // 11110000 1000____
+            static const char two_conts = static_cast<char>(1 << 7); // 10______ 10______
+            /// Errors determined by the high nibble of the first byte only
+            static const char carry = too_short | too_long | two_conts;
+        } // namespace utf8_validation
+
+        /// Back up from p (at most 3 bytes, but not before begin) to the lead byte
+        /// of a multi-byte sequence which might extend to p
+        inline const unsigned char* backup_to_lead(const unsigned char* begin, const unsigned char* p)
+        {
+            for(int i = 1; i <= 3 && p - i >= begin; i++)
+            {
+                const unsigned char c = p[-i];
+                if(c < 0x80)
+                    break;
+                if(c >= 0xC0)
+                    return p - i;
+            }
+            return p;
+        }
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+        namespace sse2 {
+            /// Bits which are zero in every ASCII code unit of the given size
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i non_ascii_bits(std::integral_constant<int, 1>)
+            {
+                return _mm_set1_epi8(static_cast<char>(0x80));
+            }
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i non_ascii_bits(std::integral_constant<int, 2>)
+            {
+                return _mm_set1_epi16(static_cast<short>(0xFF80));
+            }
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i non_ascii_bits(std::integral_constant<int, 4>)
+            {
+                return _mm_set1_epi32(static_cast<int>(0xFFFFFF80u));
+            }
+
+            BOOST_NOWIDE_TARGET_SSE2 inline bool is_zero(const __m128i v)
+            {
+                return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+            }
+
+            /// Return the end of an ASCII prefix of the code units of the given size in [begin, end),
+            /// checked in blocks of 64 and 16 bytes
+            template<int Size>
+            BOOST_NOWIDE_TARGET_SSE2 inline const unsigned char* find_non_ascii(const unsigned char* begin,
+                                                                                const unsigned char* end)
+            {
+                const __m128i mask = non_ascii_bits(std::integral_constant<int, Size>());
+                const unsigned char* p = begin;
+                while(end - p >= 64)
+                {
+                    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+                    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+                    const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48));
+                    if(!is_zero(_mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), mask)))
+                        break;
+                    p += 64;
+                }
+                while(end - p >= 16
+                      && is_zero(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), mask)))
+                    p += 16;
+                return p;
+            }
+        } // namespace sse2
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+        namespace sse41 {
+            /// Return a non-zero vector if any sequence ending in `in` is invalid,
+            /// `prev` are the 16 bytes before `in`
+            BOOST_NOWIDE_TARGET_SSE41 inline __m128i check_utf8_block(const __m128i in, const __m128i prev)
+            {
+                using namespace utf8_validation;
+                const __m128i low_nibble = _mm_set1_epi8(0x0F);
+                const __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+                const __m128i byte_1_high = _mm_shuffle_epi8(
+                  _mm_setr_epi8(too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                                two_conts, two_conts, two_conts, two_conts, too_short | overlong_2, too_short,
+                                too_short | overlong_3 | surrogate,
+                                too_short | too_large | too_large_1000 | overlong_4),
+                  _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+                const __m128i byte_1_low = _mm_shuffle_epi8(
+                  _mm_setr_epi8(carry | overlong_3 | overlong_2 | overlong_4, carry | overlong_2, carry, carry,
+                                carry | too_large, carry | too_large | too_large_1000,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000 | surrogate,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000),
+                  _mm_and_si128(prev1, low_nibble));
+                const __m128i byte_2_high = _mm_shuffle_epi8(
+                  _mm_setr_epi8(too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                                too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+                                too_long | overlong_2 | two_conts | overlong_3 | too_large,
+                                too_long | overlong_2 | two_conts | surrogate | too_large,
+                                too_long | overlong_2 | two_conts | surrogate | too_large, too_short, too_short,
+                                too_short, too_short),
+                  _mm_and_si128(_mm_srli_epi16(in, 4), low_nibble));
+                const __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+                // The 3rd and 4th byte of a sequence must be continuation bytes, which is the only case
+                // where `two_conts` is expected
+                const __m128i prev2 = _mm_alignr_epi8(in, prev, 14);
+                const __m128i prev3 = _mm_alignr_epi8(in, prev, 13);
+                const __m128i is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+                const __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+                const __m128i must23 =
+                  _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8(static_cast<char>(0x80)));
+                return _mm_xor_si128(must23, special_cases);
+            }
+
+            /// Return a non-zero vector if the block ends within a multi-byte sequence
+            BOOST_NOWIDE_TARGET_SSE41 inline __m128i is_incomplete(const __m128i in)
+            {
+                const __m128i max_value = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1),
+                                                        static_cast<char>(0xC0 - 1));
+                return _mm_subs_epu8(in, max_value);
+            }
+
+            /// Validate blocks of 16 bytes and return the position from where the scalar validation has to continue.
+            /// Everything before it is valid UTF-8.
+            BOOST_NOWIDE_TARGET_SSE41 inline const unsigned char* find_invalid_utf8(const unsigned char* begin,
+                                                                                     const unsigned char* end)
+            {
+                const unsigned char* p = begin;
+                __m128i prev = _mm_setzero_si128();
+                __m128i prev_incomplete = _mm_setzero_si128();
+                while(end - p >= 16)
+                {
+                    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    const __m128i error = (_mm_movemask_epi8(in) == 0) ? prev_incomplete : check_utf8_block(in, prev);
+                    if(!_mm_testz_si128(error, error))
+                        break;
+                    prev_incomplete = is_incomplete(in);
+                    prev = in;
+                    p += 16;
+                }
+                return backup_to_lead(begin, p);
+            }
+        } // namespace sse41
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+        namespace avx2 {
+            /// Shift in the last N bytes of `prev` in front of `in`
+            template<int N>
+            BOOST_NOWIDE_TARGET_AVX2 inline __m256i prev_bytes(const __m256i in, const __m256i prev)
+            {
+                return _mm256_alignr_epi8(in, _mm256_permute2x128_si256(prev, in, 0x21), 16 - N);
+            }
+
+            /// Use the same table for both 128 bit lanes
+            BOOST_NOWIDE_TARGET_AVX2 inline __m256i lookup(const __m128i table, const __m256i idx)
+            {
+                return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(table), idx);
+            }
+
+            /// See sse41::check_utf8_block
+            BOOST_NOWIDE_TARGET_AVX2 inline __m256i check_utf8_block(const __m256i in, const __m256i prev)
+            {
+                using namespace utf8_validation;
+                const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+                const __m256i prev1 = prev_bytes<1>(in, prev);
+                const __m256i byte_1_high = lookup(
+                  _mm_setr_epi8(too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                                two_conts, two_conts, two_conts, two_conts, too_short | overlong_2, too_short,
+                                too_short | overlong_3 | surrogate,
+                                too_short | too_large | too_large_1000 | overlong_4),
+                  _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+                const __m256i byte_1_low = lookup(
+                  _mm_setr_epi8(carry | overlong_3 | overlong_2 | overlong_4, carry | overlong_2, carry, carry,
+                                carry | too_large, carry | too_large | too_large_1000,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000 | surrogate,
+                                carry | too_large | too_large_1000, carry | too_large | too_large_1000),
+                  _mm256_and_si256(prev1, low_nibble));
+                const __m256i byte_2_high = lookup(
+                  _mm_setr_epi8(too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                                too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+                                too_long | overlong_2 | two_conts | overlong_3 | too_large,
+                                too_long | overlong_2 | two_conts | surrogate | too_large,
+                                too_long | overlong_2 | two_conts | surrogate | too_large, too_short, too_short,
+                                too_short, too_short),
+                  _mm256_and_si256(_mm256_srli_epi16(in, 4), low_nibble));
+                const __m256i special_cases =
+                  _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+                const __m256i is_third_byte =
+                  _mm256_subs_epu8(prev_bytes<2>(in, prev), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+                const __m256i is_fourth_byte =
+                  _mm256_subs_epu8(prev_bytes<3>(in, prev), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+                const __m256i must23 = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte),
+                                                        _mm256_set1_epi8(static_cast<char>(0x80)));
+                return _mm256_xor_si256(must23, special_cases);
+            }
+
+            BOOST_NOWIDE_TARGET_AVX2 inline __m256i is_incomplete(const __m256i in)
+            {
+                const __m256i max_value = _mm256_setr_epi8(
+                  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                  -1, -1, -1, -1, static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1),
+                  static_cast<char>(0xC0 - 1));
+                return _mm256_subs_epu8(in, max_value);
+            }
+
+            /// See sse41::find_invalid_utf8, uses blocks of 32 bytes
+            BOOST_NOWIDE_TARGET_AVX2 inline const unsigned char* find_invalid_utf8(const unsigned char* begin,
+                                                                                    const unsigned char* end)
+            {
+                const unsigned char* p = begin;
+                __m256i prev = _mm256_setzero_si256();
+                __m256i prev_incomplete = _mm256_setzero_si256();
+                while(end - p >= 32)
+                {
+                    const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                    const __m256i error =
+                      (_mm256_movemask_epi8(in) == 0) ? prev_incomplete : check_utf8_block(in, prev);
+                    if(!_mm256_testz_si256(error, error))
+                        return backup_to_lead(begin, p);
+                    prev_incomplete = is_incomplete(in);
+                    prev = in;
+                    p += 32;
+                }
+                // The SSE4.1 variant starts with no previous block
+                p = backup_to_lead(begin, p);
+                return sse41::find_invalid_utf8(p, end);
+            }
+
+            /// Same as sse2::find_non_ascii but checks 64 bytes per iteration with 2 AVX2 loads
+            template<int Size>
+            BOOST_NOWIDE_TARGET_AVX2 inline const unsigned char* find_non_ascii(const unsigned char* begin,
+                                                                                const unsigned char* end)
+            {
+                const __m256i mask =
+                  _mm256_broadcastsi128_si256(sse2::non_ascii_bits(std::integral_constant<int, Size>()));
+                const unsigned char* p = begin;
+                while(end - p >= 64)
+                {
+                    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+                    if(!_mm256_testz_si256(_mm256_or_si256(a, b), mask))
+                        break;
+                    p += 64;
+                }
+                return sse2::find_non_ascii<Size>(p, end);
+            }
+        } // namespace avx2
+#endif
+
+        struct utf8_validation_kernels
+        {
+            using kernel = const unsigned char* (*)(const unsigned char* begin, const unsigned char* end);
+            static const unsigned char* scalar(const unsigned char* begin, const unsigned char* /*end*/)
+            {
+                return begin;
+            }
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &avx2::find_invalid_utf8;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+                if(isa >= simd_isa::sse41)
+                    return &sse41::find_invalid_utf8;
+#endif
+                (void)isa;
+                return &scalar;
+            }
+        };
+
+        /// Find the end of the ASCII prefix of code units of the given size
+        template<int Size>
+        struct ascii_kernels
+        {
+            using kernel = const unsigned char* (*)(const unsigned char* begin, const unsigned char* end);
+            static const unsigned char* scalar(const unsigned char* begin, const unsigned char* end)
+            {
+#ifdef BOOST_NOWIDE_SWAR
+                return swar::find_non_ascii<Size>(begin, end);
+#else
+                (void)end;
+                return begin;
+#endif
+            }
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &avx2::find_non_ascii<Size>;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &sse2::find_non_ascii<Size>;
+#endif
+                (void)isa;
+                return &scalar;
+            }
+        };
+
+        /// Return true if the code unit is ASCII, i.e. below 0x80
+        template<typename Char>
+        BOOST_CXX14_CONSTEXPR bool is_ascii_unit(const Char c)
+        {
+            return static_cast<typename std::make_unsigned<Char>::type>(c) < 0x80u;
+        }
+
+        /// Return the end of an ASCII prefix of [begin, end), possibly before the first non-ASCII code unit.
+        /// Checking has to continue from there with is_ascii_unit.
+        template<typename CharIn>
+        const CharIn* ascii_prefix(const CharIn* begin, const CharIn* end)
+        {
+            const unsigned char* p = active_kernel<ascii_kernels<sizeof(CharIn)>>()(
+              reinterpret_cast<const unsigned char*>(begin), reinterpret_cast<const unsigned char*>(end));
+            return reinterpret_cast<const CharIn*>(p);
+        }
+
+        /// Size of the code units of type Char selecting the bulk kernels.
+        /// 0 for the single byte codepages of utf/codepage.hpp which must not use the UTF-8 kernels
+        template<typename Char>
+        struct code_unit_size : std::integral_constant<int, sizeof(Char)>
+        {};
+
+        /// Return the end of a valid prefix of [begin, end), possibly empty.
+        /// The validation has to continue from there with the generic decoder.
+        template<typename CharIn, int InSize = code_unit_size<CharIn>::value>
+        struct bulk_validator
+        {
+            static const CharIn* run(const CharIn* begin, const CharIn* /*end*/)
+            {
+                return begin;
+            }
+        };
+
+        /// UTF-8
+        template<typename CharIn>
+        struct bulk_validator<CharIn, 1>
+        {
+            static const CharIn* run(const CharIn* begin, const CharIn* end)
+            {
+                const unsigned char* p = active_kernel<utf8_validation_kernels>()(
+                  reinterpret_cast<const unsigned char*>(begin), reinterpret_cast<const unsigned char*>(end));
+                return reinterpret_cast<const CharIn*>(p);
+            }
+        };
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
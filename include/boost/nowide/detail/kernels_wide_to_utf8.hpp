@@ -0,0 +1,454 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_KERNELS_WIDE_TO_UTF8_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_KERNELS_WIDE_TO_UTF8_HPP_INCLUDED
+
+#include <boost/nowide/detail/simd.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <cstddef>
+#include <cstdint>
+
+//! @cond Doxygen_Suppress
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        using utf8_encoder = utf::utf_traits<unsigned char>;
+
+        /// Encode the code units [p, p + n) which must be valid code points but not surrogates
+        template<typename CharIn>
+        inline void encode_bmp_units(const CharIn*& p, unsigned n, unsigned char*& o)
+        {
+            for(; n > 0; --n)
+                o = utf8_encoder::encode(static_cast<std::uint16_t>(*p++), o);
+        }
+
+        /// Encode the surrogate pair at p (2 readable units) if it is valid
+        template<typename CharIn>
+        inline bool encode_utf16_surrogate_pair(const CharIn*& p, unsigned char*& o)
+        {
+            using utf16_traits = utf::utf_traits<CharIn, 2>;
+            const std::uint16_t w1 = static_cast<std::uint16_t>(p[0]);
+            const std::uint16_t w2 = static_cast<std::uint16_t>(p[1]);
+            if(!utf16_traits::is_first_surrogate(w1) || !utf16_traits::is_second_surrogate(w2))
+                return false;
+            o = utf8_encoder::encode(utf16_traits::combine_surrogate(w1, w2), o);
+            p += 2;
+            return true;
+        }
+
+        /// Encode the UTF-32 code units [p, p + n) up to the first invalid one.
+        /// Return false if no unit was encoded
+        template<typename CharIn>
+        inline bool encode_utf32_units(const CharIn*& p, unsigned n, unsigned char*& o)
+        {
+            const CharIn* const begin = p;
+            for(; n > 0 && utf::is_valid_codepoint(static_cast<utf::code_point>(*p)); --n)
+                o = utf8_encoder::encode(static_cast<utf::code_point>(*p++), o);
+            return p != begin;
+        }
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+        namespace sse2 {
+            /// Encode 8 code points in [0x80, 0x7FF] to 16 bytes
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i encode_two_byte_block(const __m128i v)
+            {
+                // Little endian: The lead byte goes into the low byte of each 16 bit lane
+                return _mm_or_si128(_mm_or_si128(_mm_srli_epi16(v, 6), _mm_set1_epi16(static_cast<short>(0x80C0))),
+                                    _mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x3F)), 8));
+            }
+
+            /// Classification of 8 UTF-16 code units as bitmasks with 2 bits per unit
+            struct utf16_block_info
+            {
+                BOOST_NOWIDE_TARGET_SSE2 explicit utf16_block_info(const __m128i v)
+                {
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i high_bits = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800)));
+                    ascii = static_cast<unsigned>(_mm_movemask_epi8(
+                      _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80))), zero)));
+                    up_to_two_bytes = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero)));
+                    surrogates = static_cast<unsigned>(
+                      _mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, _mm_set1_epi16(static_cast<short>(0xD800)))));
+                }
+                unsigned ascii, up_to_two_bytes, surrogates;
+            };
+
+            /// Encode 8 code points without surrogates given as 16 bit lanes of v,
+            /// p points to the same code points in the input and is advanced past them.
+            /// Requires space for 24 bytes
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            encode_bmp_block(const __m128i v, const utf16_block_info& info, const CharIn*& p, unsigned char*& o)
+            {
+                if(info.ascii == 0xFFFF)
+                {
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(o), _mm_packus_epi16(v, v));
+                    p += 8;
+                    o += 8;
+                } else if(info.up_to_two_bytes == 0xFFFF && info.ascii == 0)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), encode_two_byte_block(v));
+                    p += 8;
+                    o += 16;
+                } else
+                    encode_bmp_units(p, 8, o);
+            }
+
+            /// Handle a block containing surrogates: Encode the units before the first surrogate,
+            /// or the surrogate pair at p
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline bool
+            encode_utf16_surrogate_block(const CharIn*& p, const unsigned surrogates, unsigned char*& o)
+            {
+                const unsigned n = count_trailing_zeros(surrogates) / 2;
+                if(n > 0)
+                {
+                    encode_bmp_units(p, n, o);
+                    return true;
+                }
+                return encode_utf16_surrogate_pair(p, o);
+            }
+
+            /// Convert one block starting at p, requires 8 readable units and space for 24 bytes.
+            /// Return false if the unit at p needs to be handled by the generic decoder
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline bool utf16_to_utf8_step(const CharIn*& p, unsigned char*& o)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const utf16_block_info info(v);
+                if(info.surrogates != 0)
+                    return encode_utf16_surrogate_block(p, info.surrogates, o);
+                encode_bmp_block(v, info, p, o);
+                return true;
+            }
+
+            /// Return true if all 8 code units (32 bit each) are below 0x10000
+            BOOST_NOWIDE_TARGET_SSE2 inline bool is_bmp_block(const __m128i a, const __m128i b)
+            {
+                const __m128i high = _mm_or_si128(_mm_srli_epi32(a, 16), _mm_srli_epi32(b, 16));
+                return _mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) == 0xFFFF;
+            }
+
+            /// Pack 8 code units (32 bit each) below 0x10000 into 16 bit lanes
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i pack_bmp_block(const __m128i a, const __m128i b)
+            {
+                // There is only a signed saturating pack in SSE2, so shift the values into the signed range
+                const __m128i bias32 = _mm_set1_epi32(0x8000);
+                const __m128i packed = _mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32));
+                return _mm_add_epi16(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+            }
+
+            /// Convert one block starting at p, requires 8 readable units and space for 32 bytes.
+            /// Return false if the unit at p needs to be handled by the generic decoder
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline bool utf32_to_utf8_step(const CharIn*& p, unsigned char*& o)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+                if(is_bmp_block(a, b))
+                {
+                    const __m128i v = pack_bmp_block(a, b);
+                    const utf16_block_info info(v);
+                    if(info.surrogates == 0)
+                    {
+                        encode_bmp_block(v, info, p, o);
+                        return true;
+                    }
+                }
+                return encode_utf32_units(p, 8, o);
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf16_to_utf8(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 8 && out_end - o >= 24 && utf16_to_utf8_step(p, o))
+                {}
+                in = p;
+                out = o;
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf32_to_utf8(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 8 && out_end - o >= 32 && utf32_to_utf8_step(p, o))
+                {}
+                in = p;
+                out = o;
+            }
+
+            /// Return the UTF-8 length of the first n units (at most 8) of a block without surrogates
+            BOOST_NOWIDE_TARGET_SSE2 inline unsigned utf8_length(const utf16_block_info& info, const unsigned n)
+            {
+                const unsigned mask = (1u << (2 * n)) - 1u;
+                return n + (count_bits(~info.ascii & mask) + count_bits(~info.up_to_two_bytes & mask)) / 2;
+            }
+
+            /// Add the UTF-8 length of the UTF-16 input to `length` up to the first surrogate
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf16_utf8_length(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                const CharIn* p = in;
+                std::size_t n = length;
+                while(in_end - p >= 8)
+                {
+                    const utf16_block_info info(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+                    if(info.surrogates != 0)
+                    {
+                        const unsigned num_units = count_trailing_zeros(info.surrogates) / 2;
+                        n += utf8_length(info, num_units);
+                        p += num_units;
+                        break;
+                    }
+                    n += utf8_length(info, 8);
+                    p += 8;
+                }
+                in = p;
+                length = n;
+            }
+
+            /// Return the value as 4 32 bit lanes biased for comparing unsigned values with the signed comparisons
+            BOOST_NOWIDE_TARGET_SSE2 inline __m128i biased_epu32(const std::uint32_t value)
+            {
+                return _mm_set1_epi32(static_cast<int>(value ^ 0x80000000u));
+            }
+
+            /// Return a 4 bit mask of the lanes of the biased values `c` greater than `value`
+            BOOST_NOWIDE_TARGET_SSE2 inline unsigned greater_mask(const __m128i c, const std::uint32_t value)
+            {
+                const __m128i greater = _mm_cmpgt_epi32(c, biased_epu32(value));
+                return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(greater)));
+            }
+
+            /// Add the UTF-8 length of the UTF-32 input to `length` up to the first invalid code point
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE2 inline void
+            utf32_utf8_length(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                const CharIn* p = in;
+                std::size_t n = length;
+                while(in_end - p >= 4)
+                {
+                    const __m128i c =
+                      _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), biased_epu32(0));
+                    const unsigned invalid =
+                      greater_mask(c, 0x10FFFF) | (greater_mask(c, 0xD7FF) & ~greater_mask(c, 0xDFFF));
+                    const unsigned num_units = (invalid == 0) ? 4 : count_trailing_zeros(invalid);
+                    const unsigned mask = (1u << num_units) - 1u;
+                    n += num_units + count_bits(greater_mask(c, 0x7F) & mask)
+                         + count_bits(greater_mask(c, 0x7FF) & mask) + count_bits(greater_mask(c, 0xFFFF) & mask);
+                    p += num_units;
+                    if(invalid != 0)
+                        break;
+                }
+                in = p;
+                length = n;
+            }
+        } // namespace sse2
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+        namespace sse41 {
+            /// Encode 4 code points (32 bit each) in [0x800, 0xFFFF] to 12 bytes, the upper 4 bytes are zero
+            BOOST_NOWIDE_TARGET_SSE41 inline __m128i encode_three_byte_block(const __m128i c)
+            {
+                const __m128i b0 = _mm_srli_epi32(c, 12);
+                const __m128i b1 = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(c, 6), _mm_set1_epi32(0x3F)), 8);
+                const __m128i b2 = _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x3F)), 16);
+                const __m128i t = _mm_or_si128(_mm_or_si128(b0, b1), _mm_or_si128(b2, _mm_set1_epi32(0x008080E0)));
+                return _mm_shuffle_epi8(t, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+            }
+
+            /// Encode 8 UTF-16 code units in [0x800, 0xFFFF] without surrogates to 24 bytes
+            BOOST_NOWIDE_TARGET_SSE41 inline void store_three_byte_block(const __m128i v, unsigned char* o)
+            {
+                const __m128i lo = encode_three_byte_block(_mm_cvtepu16_epi32(v));
+                const __m128i hi = encode_three_byte_block(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(o + 16), _mm_srli_si128(hi, 4));
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE41 inline void
+            encode_bmp_block(const __m128i v, const sse2::utf16_block_info& info, const CharIn*& p, unsigned char*& o)
+            {
+                if(info.up_to_two_bytes == 0)
+                {
+                    store_three_byte_block(v, o);
+                    p += 8;
+                    o += 24;
+                } else
+                    sse2::encode_bmp_block(v, info, p, o);
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE41 inline bool utf16_to_utf8_step(const CharIn*& p, unsigned char*& o)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const sse2::utf16_block_info info(v);
+                if(info.surrogates != 0)
+                    return sse2::encode_utf16_surrogate_block(p, info.surrogates, o);
+                sse41::encode_bmp_block(v, info, p, o);
+                return true;
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE41 inline bool utf32_to_utf8_step(const CharIn*& p, unsigned char*& o)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+                if(sse2::is_bmp_block(a, b))
+                {
+                    const __m128i v = _mm_packus_epi32(a, b);
+                    const sse2::utf16_block_info info(v);
+                    if(info.surrogates == 0)
+                    {
+                        sse41::encode_bmp_block(v, info, p, o);
+                        return true;
+                    }
+                }
+                return encode_utf32_units(p, 8, o);
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE41 inline void
+            utf16_to_utf8(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 8 && out_end - o >= 24 && utf16_to_utf8_step(p, o))
+                {}
+                in = p;
+                out = o;
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_SSE41 inline void
+            utf32_to_utf8(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 8 && out_end - o >= 32 && utf32_to_utf8_step(p, o))
+                {}
+                in = p;
+                out = o;
+            }
+        } // namespace sse41
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+        namespace avx2 {
+            /// Encode 16 code points given as 16 bit lanes if they are all ASCII or all 2-byte sequences,
+            /// p points to the same code points in the input and is advanced past them.
+            /// Requires space for 32 bytes
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_AVX2 inline bool encode_bmp_block(const __m256i v, const CharIn*& p, unsigned char*& o)
+            {
+                const __m256i zero = _mm256_setzero_si256();
+                const unsigned ascii = static_cast<unsigned>(_mm256_movemask_epi8(
+                  _mm256_cmpeq_epi16(_mm256_and_si256(v, _mm256_set1_epi16(static_cast<short>(0xFF80))), zero)));
+                if(ascii == 0xFFFFFFFFu)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o),
+                                     _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+                    p += 16;
+                    o += 16;
+                    return true;
+                }
+                const unsigned up_to_two_bytes = static_cast<unsigned>(_mm256_movemask_epi8(
+                  _mm256_cmpeq_epi16(_mm256_and_si256(v, _mm256_set1_epi16(static_cast<short>(0xF800))), zero)));
+                if(up_to_two_bytes == 0xFFFFFFFFu && ascii == 0)
+                {
+                    const __m256i bytes = _mm256_or_si256(
+                      _mm256_or_si256(_mm256_srli_epi16(v, 6), _mm256_set1_epi16(static_cast<short>(0x80C0))),
+                      _mm256_slli_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x3F)), 8));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), bytes);
+                    p += 16;
+                    o += 32;
+                    return true;
+                }
+                return false;
+            }
+
+            /// Convert 16 UTF-16 code units at once if possible, requires 16 readable units and space for 32 bytes
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_AVX2 inline bool utf16_to_utf8_step256(const CharIn*& p, unsigned char*& o)
+            {
+                return encode_bmp_block(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), p, o);
+            }
+
+            /// Convert 16 UTF-32 code units at once if possible, requires 16 readable units and space for 32 bytes
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_AVX2 inline bool utf32_to_utf8_step256(const CharIn*& p, unsigned char*& o)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8));
+                const __m256i high = _mm256_or_si256(_mm256_srli_epi32(a, 16), _mm256_srli_epi32(b, 16));
+                if(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(high, _mm256_setzero_si256())))
+                   != 0xFFFFFFFFu)
+                    return false;
+                // Packing works per 128 bit lane, restore the order afterwards
+                const __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+                return encode_bmp_block(v, p, o);
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_AVX2 inline void
+            utf16_to_utf8(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 16 && out_end - o >= 32)
+                {
+                    if(!utf16_to_utf8_step256(p, o) && !sse41::utf16_to_utf8_step(p, o))
+                    {
+                        in = p;
+                        out = o;
+                        return;
+                    }
+                }
+                in = p;
+                out = o;
+                sse41::utf16_to_utf8(in, in_end, out, out_end);
+            }
+
+            template<typename CharIn>
+            BOOST_NOWIDE_TARGET_AVX2 inline void
+            utf32_to_utf8(const CharIn*& in, const CharIn* in_end, unsigned char*& out, unsigned char* out_end)
+            {
+                const CharIn* p = in;
+                unsigned char* o = out;
+                while(in_end - p >= 16 && out_end - o >= 32)
+                {
+                    if(!utf32_to_utf8_step256(p, o) && !sse41::utf32_to_utf8_step(p, o))
+                    {
+                        in = p;
+                        out = o;
+                        return;
+                    }
+                }
+                in = p;
+                out = o;
+                sse41::utf32_to_utf8(in, in_end, out, out_end);
+            }
+        } // namespace avx2
+#endif
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
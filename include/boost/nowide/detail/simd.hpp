@@ -0,0 +1,163 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_SIMD_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_SIMD_HPP_INCLUDED
+
+#include <boost/nowide/config.hpp>
+
+//! @cond Doxygen_Suppress
+
+// Detect the instruction sets for which the bulk conversion kernels are compiled.
+// Define BOOST_NOWIDE_NO_SIMD to use only the portable code paths.
+//
+// Where the compiler allows using intrinsics of instruction sets not enabled on the command line
+// (GCC/Clang via the target attribute, MSVC always) all kernels are compiled
+// and the best one for the running CPU can be chosen at runtime, see BOOST_NOWIDE_RUNTIME_DISPATCH.
+// Otherwise only the kernels for the instruction sets enabled at compile time are available.
+#if !defined(BOOST_NOWIDE_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define BOOST_NOWIDE_SIMD_SSE2 1
+#define BOOST_NOWIDE_SIMD_SSE41 1
+#define BOOST_NOWIDE_SIMD_AVX2 1
+#define BOOST_NOWIDE_TARGET_SSE2 __attribute__((target("sse2")))
+#define BOOST_NOWIDE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define BOOST_NOWIDE_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER)
+#define BOOST_NOWIDE_SIMD_SSE2 1
+#define BOOST_NOWIDE_SIMD_SSE41 1
+#define BOOST_NOWIDE_SIMD_AVX2 1
+#else
+#if defined(__SSE2__)
+#define BOOST_NOWIDE_SIMD_SSE2 1
+#endif
+#if defined(__SSE4_1__)
+#define BOOST_NOWIDE_SIMD_SSE41 1
+#endif
+#if defined(__AVX2__)
+#define BOOST_NOWIDE_SIMD_AVX2 1
+#endif
+#endif
+#endif
+
+// Where no SIMD kernel is available (other architectures, BOOST_NOWIDE_NO_SIMD or a CPU without SSE2)
+// portable kernels processing 64 bit words at a time (SWAR) are used.
+// Define BOOST_NOWIDE_NO_SWAR to use the per code point conversion instead.
+#ifndef BOOST_NOWIDE_NO_SWAR
+#define BOOST_NOWIDE_SWAR 1
+#endif
+
+#ifndef BOOST_NOWIDE_TARGET_SSE2
+#define BOOST_NOWIDE_TARGET_SSE2
+#define BOOST_NOWIDE_TARGET_SSE41
+#define BOOST_NOWIDE_TARGET_AVX2
+#endif
+
+// Kernels which may read past the end of the input within an aligned block (which is always readable)
+// would be reported by AddressSanitizer
+#if defined(__clang__) || defined(__GNUC__)
+#define BOOST_NOWIDE_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined(_MSC_VER) && _MSC_VER >= 1927
+#define BOOST_NOWIDE_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#else
+#define BOOST_NOWIDE_NO_SANITIZE_ADDRESS
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        /// Instruction set extensions usable by the conversion kernels, ordered by capability
+        enum class simd_isa
+        {
+            scalar,
+            sse2,
+            sse41,
+            avx2,
+            avx512bw
+        };
+
+        /// Instruction set enabled at compile time, i.e. usable without runtime checks
+        constexpr simd_isa compiled_simd_isa =
+#if defined(BOOST_NOWIDE_NO_SIMD)
+          simd_isa::scalar;
+#elif defined(__AVX512BW__)
+          simd_isa::avx512bw;
+#elif defined(__AVX2__)
+          simd_isa::avx2;
+#elif defined(__SSE4_1__) || defined(__AVX__)
+          simd_isa::sse41;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+          simd_isa::sse2;
+#else
+          simd_isa::scalar;
+#endif
+
+        /// Instruction set of the running CPU, detected once by the compiled library.
+        /// Can be lowered (e.g. for testing) by setting the environment variable BOOST_NOWIDE_FORCE_ISA
+        /// to one of "scalar", "sse2", "sse4.1" (or "sse41"), "avx2", "avx512bw".
+        /// Other values are ignored after a warning on stderr.
+        BOOST_NOWIDE_DECL simd_isa runtime_simd_isa();
+
+        /// Return the kernel chosen by `Kernels::select` for the active instruction set.
+        /// With BOOST_NOWIDE_RUNTIME_DISPATCH (requires linking the library) the choice is made once,
+        /// otherwise it is a compile time constant.
+        template<typename Kernels>
+        typename Kernels::kernel active_kernel()
+        {
+#ifdef BOOST_NOWIDE_RUNTIME_DISPATCH
+            static const typename Kernels::kernel kernel = Kernels::select(runtime_simd_isa());
+            return kernel;
+#else
+            return Kernels::select(compiled_simd_isa);
+#endif
+        }
+
+        /// Return the index of the lowest set bit of a non-zero value
+        inline unsigned count_trailing_zeros(unsigned value)
+        {
+#if defined(_MSC_VER)
+            unsigned long idx;
+            _BitScanForward(&idx, value);
+            return static_cast<unsigned>(idx);
+#elif defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_ctz(value));
+#else
+            unsigned idx = 0;
+            while(!(value & 1u))
+            {
+                value >>= 1;
+                ++idx;
+            }
+            return idx;
+#endif
+        }
+
+        /// Return the number of set bits
+        inline unsigned count_bits(unsigned value)
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_popcount(value));
+#else
+            value = value - ((value >> 1) & 0x55555555u);
+            value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+            return (((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+#endif
+        }
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
@@ -0,0 +1,775 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_TRANSCODE_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_TRANSCODE_HPP_INCLUDED
+
+#include <boost/nowide/detail/kernels_count.hpp>
+#include <boost/nowide/detail/kernels_swar.hpp>
+#include <boost/nowide/detail/kernels_terminator.hpp>
+#include <boost/nowide/detail/kernels_utf16_utf32.hpp>
+#include <boost/nowide/detail/kernels_utf8_to_wide.hpp>
+#include <boost/nowide/detail/kernels_validate.hpp>
+#include <boost/nowide/detail/kernels_wide_to_utf8.hpp>
+#include <boost/nowide/replacement.hpp>
+#include <boost/nowide/utf/error_policy.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+//! @cond Doxygen_Suppress
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        /// Converts a prefix of the input in bulk.
+        ///
+        /// `run` advances `in` and `out` past the converted part and stops at the end of either range
+        /// or at the first code point it doesn't handle, e.g. an invalid sequence.
+        /// The generic decoder then continues with that code point.
+        /// Output is identical to decoding & encoding each code point via utf_traits.
+        /// The default does nothing.
+        template<typename CharOut,
+                 typename CharIn,
+                 int OutSize = code_unit_size<CharOut>::value,
+                 int InSize = code_unit_size<CharIn>::value>
+        struct bulk_transcoder
+        {
+            static void run(const CharIn*& /*in*/, const CharIn* /*in_end*/, CharOut*& /*out*/, CharOut* /*out_end*/)
+            {}
+        };
+
+        /// Counts the output length of a prefix of the input in bulk, similar to bulk_transcoder.
+        ///
+        /// `run` advances `in` and adds the number of code units the conversion of the consumed input produces
+        /// to `length`. The default does nothing.
+        template<typename CharOut,
+                 typename CharIn,
+                 int OutSize = code_unit_size<CharOut>::value,
+                 int InSize = code_unit_size<CharIn>::value>
+        struct bulk_counter
+        {
+            static void run(const CharIn*& /*in*/, const CharIn* /*in_end*/, std::size_t& /*length*/)
+            {}
+        };
+
+        /// Checks whether a code point can be encoded as CharOut.
+        ///
+        /// Only a single byte codepage (size 0) can't represent all code points,
+        /// those code points are handled like invalid sequences by transcode and count_output.
+        template<typename CharOut, int OutSize = code_unit_size<CharOut>::value>
+        struct encodable
+        {
+            static constexpr bool check(utf::code_point /*c*/)
+            {
+                return true;
+            }
+        };
+
+        /// Kernel converting a prefix of [in, in_end) to [out, out_end), see bulk_transcoder
+        template<typename CharOut, typename CharIn>
+        using bulk_kernel = void (*)(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end);
+
+        template<typename CharOut, typename CharIn>
+        void no_bulk_kernel(const CharIn*& /*in*/, const CharIn* /*in_end*/, CharOut*& /*out*/, CharOut* /*out_end*/)
+        {}
+
+#if defined(BOOST_NOWIDE_SIMD_SSE2) || defined(BOOST_NOWIDE_SWAR)
+        /// UTF-8 -> UTF-16/32
+        template<typename CharOut, typename CharIn>
+        struct utf8_to_wide_kernels
+        {
+            using kernel = bulk_kernel<CharOut, CharIn>;
+            template<typename Kernel>
+            static void call(Kernel kernel, const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+                kernel(p, reinterpret_cast<const unsigned char*>(in_end), out, out_end);
+                in = reinterpret_cast<const CharIn*>(p);
+            }
+#ifdef BOOST_NOWIDE_SWAR
+            static void run_swar(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&swar::utf8_to_wide<CharOut>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+            static void run_sse2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&sse2::utf8_to_wide<CharOut>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+            static void run_sse41(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&sse41::utf8_to_wide<CharOut>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+            static void run_avx2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&avx2::utf8_to_wide<CharOut>, in, in_end, out, out_end);
+            }
+#endif
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &run_avx2;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+                if(isa >= simd_isa::sse41)
+                    return &run_sse41;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &run_sse2;
+#endif
+                (void)isa;
+#ifdef BOOST_NOWIDE_SWAR
+                return &run_swar;
+#else
+                return &no_bulk_kernel<CharOut, CharIn>;
+#endif
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 2, 1>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                active_kernel<utf8_to_wide_kernels<CharOut, CharIn>>()(in, in_end, out, out_end);
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 4, 1> : bulk_transcoder<CharOut, CharIn, 2, 1>
+        {};
+
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+        /// UTF-8 -> UTF-16/32 length: Count the code points (and 4 byte sequences for UTF-16)
+        /// of the prefix found valid by the vectorized validator
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 2, 1>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                const CharIn* const valid_end = bulk_validator<CharIn>::run(in, in_end);
+                length += count_utf8_units<sizeof(CharOut)>(in, valid_end);
+                in = valid_end;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 4, 1> : bulk_counter<CharOut, CharIn, 2, 1>
+        {};
+
+        /// UTF-8 -> UTF-8, e.g. between char and char8_t: Copy the prefix found valid by the vectorized validator
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 1, 1>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const CharIn* const end = (out_end - out < in_end - in) ? in + (out_end - out) : in_end;
+                const CharIn* const valid_end = bulk_validator<CharIn>::run(in, end);
+                const std::size_t n = static_cast<std::size_t>(valid_end - in);
+                if(n != 0)
+                    std::memcpy(out, in, n);
+                in = valid_end;
+                out += n;
+            }
+        };
+        /// UTF-8 -> UTF-8 length: Valid input is copied unchanged
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 1, 1>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                const CharIn* const valid_end = bulk_validator<CharIn>::run(in, in_end);
+                length += static_cast<std::size_t>(valid_end - in);
+                in = valid_end;
+            }
+        };
+#endif
+
+        /// UTF-16 -> UTF-8
+        template<typename CharOut, typename CharIn>
+        struct utf16_to_utf8_kernels
+        {
+            using kernel = bulk_kernel<CharOut, CharIn>;
+            template<typename Kernel>
+            static void call(Kernel kernel, const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                unsigned char* o = reinterpret_cast<unsigned char*>(out);
+                kernel(in, in_end, o, reinterpret_cast<unsigned char*>(out_end));
+                out = reinterpret_cast<CharOut*>(o);
+            }
+#ifdef BOOST_NOWIDE_SWAR
+            static void run_swar(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&swar::utf16_to_utf8<CharIn>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+            static void run_sse2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&sse2::utf16_to_utf8<CharIn>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+            static void run_sse41(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&sse41::utf16_to_utf8<CharIn>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+            static void run_avx2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&avx2::utf16_to_utf8<CharIn>, in, in_end, out, out_end);
+            }
+#endif
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &run_avx2;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+                if(isa >= simd_isa::sse41)
+                    return &run_sse41;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &run_sse2;
+#endif
+                (void)isa;
+#ifdef BOOST_NOWIDE_SWAR
+                return &run_swar;
+#else
+                return &no_bulk_kernel<CharOut, CharIn>;
+#endif
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 1, 2>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                active_kernel<utf16_to_utf8_kernels<CharOut, CharIn>>()(in, in_end, out, out_end);
+            }
+        };
+
+        /// UTF-32 -> UTF-8
+        template<typename CharOut, typename CharIn>
+        struct utf32_to_utf8_kernels
+        {
+            using kernel = bulk_kernel<CharOut, CharIn>;
+#ifdef BOOST_NOWIDE_SWAR
+            static void run_swar(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                utf16_to_utf8_kernels<CharOut, CharIn>::call(&swar::utf32_to_utf8<CharIn>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+            static void run_sse2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                utf16_to_utf8_kernels<CharOut, CharIn>::call(&sse2::utf32_to_utf8<CharIn>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+            static void run_sse41(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                utf16_to_utf8_kernels<CharOut, CharIn>::call(&sse41::utf32_to_utf8<CharIn>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+            static void run_avx2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                utf16_to_utf8_kernels<CharOut, CharIn>::call(&avx2::utf32_to_utf8<CharIn>, in, in_end, out, out_end);
+            }
+#endif
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &run_avx2;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+                if(isa >= simd_isa::sse41)
+                    return &run_sse41;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &run_sse2;
+#endif
+                (void)isa;
+#ifdef BOOST_NOWIDE_SWAR
+                return &run_swar;
+#else
+                return &no_bulk_kernel<CharOut, CharIn>;
+#endif
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 1, 4>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                active_kernel<utf32_to_utf8_kernels<CharOut, CharIn>>()(in, in_end, out, out_end);
+            }
+        };
+
+        /// UTF-16/32 -> UTF-8 length
+        template<typename CharIn>
+        struct utf8_length_kernels
+        {
+            using kernel = void (*)(const CharIn*& in, const CharIn* in_end, std::size_t& length);
+            static void scalar(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+#ifdef BOOST_NOWIDE_SWAR
+                // Count only the ASCII prefix, which results in one code unit each
+                const CharIn* p = reinterpret_cast<const CharIn*>(swar::find_non_ascii<sizeof(CharIn)>(
+                  reinterpret_cast<const unsigned char*>(in), reinterpret_cast<const unsigned char*>(in_end)));
+                length += static_cast<std::size_t>(p - in);
+                in = p;
+#else
+                (void)in;
+                (void)in_end;
+                (void)length;
+#endif
+            }
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return (sizeof(CharIn) == 2) ? &sse2::utf16_utf8_length<CharIn> : &sse2::utf32_utf8_length<CharIn>;
+#endif
+                (void)isa;
+                return &scalar;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 1, 2>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                active_kernel<utf8_length_kernels<CharIn>>()(in, in_end, length);
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 1, 4> : bulk_counter<CharOut, CharIn, 1, 2>
+        {};
+#endif
+
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+        /// UTF-16 -> UTF-32
+        template<typename CharOut, typename CharIn>
+        struct utf16_to_utf32_kernels
+        {
+            using kernel = bulk_kernel<CharOut, CharIn>;
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &avx2::utf16_to_utf32<CharIn, CharOut>;
+#endif
+                if(isa >= simd_isa::sse2)
+                    return &sse2::utf16_to_utf32<CharIn, CharOut>;
+                return &no_bulk_kernel<CharOut, CharIn>;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 4, 2>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                active_kernel<utf16_to_utf32_kernels<CharOut, CharIn>>()(in, in_end, out, out_end);
+            }
+        };
+
+        /// UTF-32 -> UTF-16
+        template<typename CharOut, typename CharIn>
+        struct utf32_to_utf16_kernels
+        {
+            using kernel = bulk_kernel<CharOut, CharIn>;
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &avx2::utf32_to_utf16<CharIn, CharOut>;
+#endif
+                if(isa >= simd_isa::sse2)
+                    return &sse2::utf32_to_utf16<CharIn, CharOut>;
+                return &no_bulk_kernel<CharOut, CharIn>;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 2, 4>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                active_kernel<utf32_to_utf16_kernels<CharOut, CharIn>>()(in, in_end, out, out_end);
+            }
+        };
+
+        /// UTF-16 <-> UTF-32 length
+        template<typename CharOut, typename CharIn>
+        struct utf16_utf32_length_kernels
+        {
+            using kernel = void (*)(const CharIn*& in, const CharIn* in_end, std::size_t& length);
+            static void scalar(const CharIn*& /*in*/, const CharIn* /*in_end*/, std::size_t& /*length*/)
+            {}
+            static kernel select(const simd_isa isa)
+            {
+                if(isa < simd_isa::sse2)
+                    return &scalar;
+                return (sizeof(CharIn) == 2) ? &sse2::utf16_utf32_length<CharIn> : &sse2::utf32_utf16_length<CharIn>;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 4, 2>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                active_kernel<utf16_utf32_length_kernels<CharOut, CharIn>>()(in, in_end, length);
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 2, 4> : bulk_counter<CharOut, CharIn, 4, 2>
+        {};
+#endif
+
+#ifdef BOOST_NOWIDE_TEST_COUNT_BULK
+        /// Test hook: Number of input code units consumed by the bulk kernels called from transcode and count_output
+        inline std::size_t& bulk_consumed_units()
+        {
+            static std::size_t count = 0;
+            return count;
+        }
+#endif
+
+        /// Call bulk_transcoder, counting the consumed input with BOOST_NOWIDE_TEST_COUNT_BULK
+        template<typename CharOut, typename CharIn>
+        void run_bulk_transcoder(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+        {
+#ifdef BOOST_NOWIDE_TEST_COUNT_BULK
+            const CharIn* const in_begin = in;
+            bulk_transcoder<CharOut, CharIn>::run(in, in_end, out, out_end);
+            bulk_consumed_units() += static_cast<std::size_t>(in - in_begin);
+#else
+            bulk_transcoder<CharOut, CharIn>::run(in, in_end, out, out_end);
+#endif
+        }
+        /// Call bulk_counter, counting the consumed input with BOOST_NOWIDE_TEST_COUNT_BULK
+        template<typename CharOut, typename CharIn>
+        void run_bulk_counter(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+        {
+#ifdef BOOST_NOWIDE_TEST_COUNT_BULK
+            const CharIn* const in_begin = in;
+            bulk_counter<CharOut, CharIn>::run(in, in_end, length);
+            bulk_consumed_units() += static_cast<std::size_t>(in - in_begin);
+#else
+            bulk_counter<CharOut, CharIn>::run(in, in_end, length);
+#endif
+        }
+
+        /// Return true if called during constant evaluation where the SIMD kernels can't be used
+        BOOST_NOWIDE_CONSTEXPR_CONVERT inline bool is_constant_evaluated()
+        {
+#ifdef BOOST_NOWIDE_IS_CONSTANT_EVALUATED
+            return BOOST_NOWIDE_IS_CONSTANT_EVALUATED();
+#else
+            return false;
+#endif
+        }
+
+        /// Copy the run of ASCII code units at the start of [in, in_end) to [out, out_end) as far as it fits.
+        /// Used after the bulk kernels for short inputs and tails, bypassing the generic decoder & encoder
+        template<typename CharOut, typename CharIn>
+        BOOST_CXX14_CONSTEXPR void copy_ascii(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+        {
+            while(in != in_end && out != out_end && is_ascii_unit(*in))
+                *out++ = static_cast<CharOut>(*in++);
+        }
+
+        /// Result of transcode with an error policy
+        enum class transcode_status
+        {
+            complete,    ///< All input was converted
+            output_full, ///< The next code point doesn't fit into the output
+            invalid      ///< Stopped at an invalid sequence or unencodable code point (utf::strict only)
+        };
+
+        /// Convert the range [begin, end) to the output range [out, out_end)
+        /// handling invalid sequences as specified by the error \a policy.
+        /// Code points which CharOut can't represent (see encodable) are handled the same, with any policy.
+        /// Stops when the next code point doesn't fit into the output or, with utf::strict, at an invalid sequence.
+        /// \a begin and \a out will point past the consumed input and written output respectively.
+        /// \a replacements is incremented for each replaced sequence.
+        template<typename CharOut, typename CharIn, typename Policy>
+        BOOST_NOWIDE_CONSTEXPR_CONVERT transcode_status transcode(const CharIn*& begin,
+                                                                  const CharIn* end,
+                                                                  CharOut*& out,
+                                                                  CharOut* out_end,
+                                                                  std::size_t& replacements,
+                                                                  Policy policy)
+        {
+            while(begin != end)
+            {
+                // Not cached in a const variable: Its initializer would always be constant evaluated
+                if(!is_constant_evaluated())
+                    run_bulk_transcoder(begin, end, out, out_end);
+                copy_ascii(begin, end, out, out_end);
+                if(begin == end)
+                    break;
+                const CharIn* const cur = begin;
+                utf::code_point c = decode_code_point(begin, end, policy);
+                const bool is_valid = (std::is_same<Policy, utf::assume_valid_t>::value
+                                       || (c != utf::illegal && c != utf::incomplete))
+                                      && encodable<CharOut>::check(c);
+                if(!is_valid)
+                {
+                    if(stops_at_error<Policy>::value)
+                    {
+                        begin = cur;
+                        return transcode_status::invalid;
+                    }
+                    c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
+                }
+                if(out_end - out < utf::utf_traits<CharOut>::width(c))
+                {
+                    begin = cur;
+                    return transcode_status::output_full;
+                }
+                out = utf::utf_traits<CharOut>::encode(c, out);
+                if(!is_valid)
+                    ++replacements;
+            }
+            return transcode_status::complete;
+        }
+
+        /// Convert the range [begin, end) to the output range [out, out_end) replacing invalid sequences.
+        /// Stops when the next code point doesn't fit into the output.
+        /// \a begin and \a out will point past the consumed input and written output respectively.
+        /// \a replacements is incremented for each replaced sequence.
+        /// \return true if all input was converted
+        template<typename CharOut, typename CharIn>
+        BOOST_NOWIDE_CONSTEXPR_CONVERT bool
+        transcode(const CharIn*& begin, const CharIn* end, CharOut*& out, CharOut* out_end, std::size_t& replacements)
+        {
+            return transcode(begin, end, out, out_end, replacements, utf::replace_t()) == transcode_status::complete;
+        }
+        template<typename CharOut, typename CharIn>
+        BOOST_NOWIDE_CONSTEXPR_CONVERT bool
+        transcode(const CharIn*& begin, const CharIn* end, CharOut*& out, CharOut* out_end)
+        {
+            std::size_t replacements = 0;
+            return transcode(begin, end, out, out_end, replacements);
+        }
+
+        /// Return the number of code units required to convert [begin, end)
+        /// handling invalid sequences and unencodable code points as specified by the error \a policy, see transcode.
+        /// \a begin is advanced to \a end or, with utf::strict, to the first invalid sequence.
+        /// \a replacements is incremented for each sequence to be replaced.
+        template<typename CharOut, typename CharIn, typename Policy>
+        std::size_t count_output(const CharIn*& begin, const CharIn* end, std::size_t& replacements, Policy policy)
+        {
+            std::size_t length = 0;
+            while(begin != end)
+            {
+                run_bulk_counter<CharOut>(begin, end, length);
+                for(; begin != end && is_ascii_unit(*begin); ++begin)
+                    ++length;
+                if(begin == end)
+                    break;
+                const CharIn* const cur = begin;
+                utf::code_point c = decode_code_point(begin, end, policy);
+                if((!std::is_same<Policy, utf::assume_valid_t>::value && (c == utf::illegal || c == utf::incomplete))
+                   || !encodable<CharOut>::check(c))
+                {
+                    if(stops_at_error<Policy>::value)
+                    {
+                        begin = cur;
+                        break;
+                    }
+                    c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
+                    ++replacements;
+                }
+                length += static_cast<std::size_t>(utf::utf_traits<CharOut>::width(c));
+            }
+            return length;
+        }
+
+        /// Return the number of code units required to convert [begin, end) replacing invalid sequences.
+        /// \a replacements is incremented for each sequence to be replaced.
+        template<typename CharOut, typename CharIn>
+        std::size_t output_length(const CharIn* begin, const CharIn* end, std::size_t& replacements)
+        {
+            return count_output<CharOut>(begin, end, replacements, utf::replace_t());
+        }
+        template<typename CharOut, typename CharIn>
+        std::size_t output_length(const CharIn* begin, const CharIn* end)
+        {
+            std::size_t replacements = 0;
+            return output_length<CharOut>(begin, end, replacements);
+        }
+
+        /// Return true if decoding the range [begin, end) sequentially starts a new code point at \a p.
+        ///
+        /// This is not only the case if *p is a lead code unit:
+        /// An invalid sequence includes the first non-trail unit following a lead of a multi-unit sequence,
+        /// so \a p is no boundary if any of the preceding (up to max_width-1) trails belongs to such a lead.
+        template<typename CharIn>
+        bool is_code_point_boundary(const CharIn* begin, const CharIn* p)
+        {
+            using traits = utf::utf_traits<CharIn>;
+            const CharIn* cur = p;
+            while(cur != begin && p - cur < traits::max_width - 1)
+            {
+                --cur;
+                if(traits::trail_length(*cur) >= p - cur)
+                    return false;
+                if(!traits::is_trail(*cur))
+                    break;
+            }
+            return true;
+        }
+
+        /// Number of code units searched for the terminator of a string before converting them,
+        /// small enough for them to be still in the L1 cache when converted
+        static const std::size_t terminated_chunk_size = 1024;
+
+        /// Split the NULL terminated string at \a begin into chunks ending at code point boundaries
+        /// and call `f(chunk_begin, chunk_end)` for each until f returns false.
+        /// Each chunk is processed directly after searching it for the terminator while it is in cache,
+        /// so a separate pass to determine the length of the string is avoided.
+        /// \return The end of the last chunk passed to f, i.e. the terminating NULL if f always returned true
+        template<typename CharIn, typename Function>
+        const CharIn* for_each_terminated_chunk(const CharIn* begin, Function f)
+        {
+            while(true)
+            {
+                const CharIn* end = find_terminator(begin, terminated_chunk_size);
+                // Complete a sequence started in the chunk, the string continues at least until the terminator
+                while(*end != 0 && !is_code_point_boundary(begin, end))
+                    ++end;
+                if(!f(begin, end) || *end == 0)
+                    return end;
+                begin = end;
+            }
+        }
+
+        /// Same as transcode for the NULL terminated string at \a begin
+        /// which will point to the terminator if all input was converted
+        template<typename CharOut, typename CharIn, typename Policy>
+        transcode_status transcode_terminated(const CharIn*& begin,
+                                              CharOut*& out,
+                                              CharOut* out_end,
+                                              std::size_t& replacements,
+                                              Policy policy)
+        {
+            transcode_status status = transcode_status::complete;
+            for_each_terminated_chunk(begin, [&](const CharIn* chunk_begin, const CharIn* chunk_end) {
+                begin = chunk_begin;
+                status = transcode(begin, chunk_end, out, out_end, replacements, policy);
+                return status == transcode_status::complete;
+            });
+            return status;
+        }
+
+        /// Same as count_output for the NULL terminated string at \a begin
+        /// which will point to the terminator or, with utf::strict, to the first invalid sequence
+        template<typename CharOut, typename CharIn, typename Policy>
+        std::size_t count_output_terminated(const CharIn*& begin, std::size_t& replacements, Policy policy)
+        {
+            std::size_t length = 0;
+            for_each_terminated_chunk(begin, [&](const CharIn* chunk_begin, const CharIn* chunk_end) {
+                begin = chunk_begin;
+                length += count_output<CharOut>(begin, chunk_end, replacements, policy);
+                return begin == chunk_end;
+            });
+            return length;
+        }
+
+        /// Maximum number of output code units per input code unit.
+        /// A byte of a single byte codepage (size 0) is a single code point below 0x10000
+        template<typename CharOut,
+                 typename CharIn,
+                 int OutSize = code_unit_size<CharOut>::value,
+                 int InSize = code_unit_size<CharIn>::value>
+        struct max_growth : std::integral_constant<std::size_t,
+                                                   (OutSize == 0)                    ? 1
+                                                   : (InSize == 0)                   ? (OutSize == 1 ? 3 : 1)
+                                                   : (OutSize == 1 && InSize == 1)   ? 3
+                                                   : (OutSize >= InSize)             ? 1
+                                                   : (OutSize == 2)                  ? 2
+                                                   : (InSize == 2)                   ? 3
+                                                                                     : 4>
+        {};
+
+        /// Return a buffer size sufficient to convert [begin, end).
+        /// Exact for the conversions which may grow the string, i.e. from UTF-16/32 to UTF-8 (by a factor of up to 3),
+        /// from UTF-8 to UTF-8 (a replaced byte takes 3) and from UTF-32 to UTF-16 (up to 2),
+        /// and an upper bound which is cheap to compute otherwise:
+        /// Each input code unit results in at most one output code unit.
+        template<typename CharOut, typename CharIn, typename Policy>
+        std::size_t output_size(const CharIn* begin, const CharIn* end, Policy policy, std::true_type /*may_grow*/)
+        {
+            std::size_t replacements = 0;
+            return count_output<CharOut>(begin, end, replacements, policy);
+        }
+        template<typename CharOut, typename CharIn, typename Policy>
+        std::size_t output_size(const CharIn* begin, const CharIn* end, Policy, std::false_type /*may_grow*/)
+        {
+            return static_cast<std::size_t>(end - begin);
+        }
+        /// With utf::strict the (exact) size is only that of the part before the first invalid sequence
+        template<typename CharOut, typename CharIn, typename Policy = utf::replace_t>
+        std::size_t output_size(const CharIn* begin, const CharIn* end, Policy policy = Policy())
+        {
+            using may_grow = std::integral_constant<bool, (max_growth<CharOut, CharIn>::value > 1)>;
+            return output_size<CharOut>(begin, end, policy, may_grow());
+        }
+
+        /// Same as output_size for the NULL terminated string at \a begin, \a end is set to its terminator
+        template<typename CharOut, typename CharIn, typename Policy>
+        std::size_t
+        output_size_terminated(const CharIn* begin, const CharIn*& end, Policy policy, std::true_type /*may_grow*/)
+        {
+            std::size_t length = 0;
+            bool stopped = false;
+            end = for_each_terminated_chunk(begin, [&](const CharIn* chunk_begin, const CharIn* chunk_end) {
+                if(!stopped)
+                {
+                    std::size_t replacements = 0;
+                    length += count_output<CharOut>(chunk_begin, chunk_end, replacements, policy);
+                    stopped = chunk_begin != chunk_end;
+                }
+                return true;
+            });
+            return length;
+        }
+        template<typename CharOut, typename CharIn, typename Policy>
+        std::size_t
+        output_size_terminated(const CharIn* begin, const CharIn*& end, Policy, std::false_type /*may_grow*/)
+        {
+            const std::size_t length = string_length(begin);
+            end = begin + length;
+            return length;
+        }
+        template<typename CharOut, typename CharIn, typename Policy = utf::replace_t>
+        std::size_t output_size_terminated(const CharIn* begin, const CharIn*& end, Policy policy = Policy())
+        {
+            using may_grow = std::integral_constant<bool, (max_growth<CharOut, CharIn>::value > 1)>;
+            return output_size_terminated<CharOut>(begin, end, policy, may_grow());
+        }
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
@@ -0,0 +1,86 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_DETAIL_UTF8_DFA_HPP_INCLUDED
+#define BOOST_NOWIDE_DETAIL_UTF8_DFA_HPP_INCLUDED
+
+//! @cond Doxygen_Suppress
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        /// Tables of a deterministic finite automaton decoding UTF-8, in the style of Bjoern Hoehrmann's decoder.
+        ///
+        /// Each byte is mapped to one of 12 classes, the next state is looked up by the current state and that class.
+        /// States are premultiplied by the number of classes so the lookup is `transitions[state + byte_class[b]]`.
+        ///
+        /// Unlike a validating DFA which rejects e.g. an overlong sequence at its second byte, this one matches
+        /// utf_traits<char>::decode exactly: Such sequences are consumed up to their full length
+        /// (or an unexpected non-trail byte) and then end in `rollback` (decode resumes after the lead byte)
+        /// or `reject` (all bytes consumed).
+        template<typename T = void>
+        struct utf8_dfa
+        {
+            // Classes: ASCII, trail [80, 8F], trail [90, 9F], trail [A0, BF], invalid lead (C0, C1, F5-FF),
+            // lead of 2 bytes, E0, lead of 3 bytes (E1-EC, EE, EF), ED, F0, lead of 4 bytes (F1-F3), F4
+
+            /// Complete code point
+            static constexpr unsigned accept = 0;
+            /// Invalid sequence, all consumed bytes belong to it
+            static constexpr unsigned reject = 12;
+            /// Overlong, surrogate or too large code point, only the lead byte belongs to it
+            static constexpr unsigned rollback = 24;
+            /// All states from here on require another trail byte
+            static constexpr unsigned first_pending = 36;
+
+            static constexpr unsigned char byte_class[256] = {
+              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0, 0, 0, 0, 0, 0, 0, //
+              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0, 0, 0, 0, 0, 0, 0, //
+              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0, 0, 0, 0, 0, 0, 0, //
+              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0, 0, 0, 0, 0, 0, 0, //
+              1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2,  2,  2,  2,  2,  2, 2, 2, 2, 2, 2, 2, //
+              3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,  3,  3,  3,  3,  3, 3, 3, 3, 3, 3, 3, //
+              4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,  5,  5,  5,  5,  5, 5, 5, 5, 5, 5, 5, //
+              6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 7, 9, 10, 10, 10, 11, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, //
+            };
+
+            /// Bits of a lead byte of each class contributing to the code point
+            static constexpr unsigned char lead_mask[12] = {0x7F, 0, 0, 0, 0, 0x1F, 0x0F, 0x0F, 0x0F, 0x07, 0x07, 0x07};
+
+            static constexpr unsigned char transitions[12 * 12] = {
+              // clang-format off
+              //  ASCII 80-8F 90-9F A0-BF  inv  lead2  E0  lead3  ED    F0  lead4  F4
+                  0,    12,   12,   12,   12,   36,   72,   48,   84,   96,   60,  108, // accept (start)
+                  12,   12,   12,   12,   12,   12,   12,   12,   12,   12,   12,   12, // reject
+                  12,   12,   12,   12,   12,   12,   12,   12,   12,   12,   12,   12, // rollback
+                  12,   0,    0,    0,    12,   12,   12,   12,   12,   12,   12,   12, // 1 trail pending
+                  12,   36,   36,   36,   12,   12,   12,   12,   12,   12,   12,   12, // 2 trails pending
+                  12,   48,   48,   48,   12,   12,   12,   12,   12,   12,   12,   12, // 3 trails pending
+                  12,   120,  120,  36,   12,   12,   12,   12,   12,   12,   12,   12, // after E0: 80-9F overlong
+                  12,   36,   36,   120,  12,   12,   12,   12,   12,   12,   12,   12, // after ED: A0-BF surrogate
+                  12,   132,  48,   48,   12,   12,   12,   12,   12,   12,   12,   12, // after F0: 80-8F overlong
+                  12,   48,   132,  132,  12,   12,   12,   12,   12,   12,   12,   12, // after F4: 90-BF too large
+                  12,   24,   24,   24,   12,   12,   12,   12,   12,   12,   12,   12, // invalid, 1 trail pending
+                  12,   120,  120,  120,  12,   12,   12,   12,   12,   12,   12,   12, // invalid, 2 trails pending
+              // clang-format on
+            };
+        };
+#ifndef __cpp_inline_variables
+        template<typename T>
+        constexpr unsigned char utf8_dfa<T>::byte_class[256];
+        template<typename T>
+        constexpr unsigned char utf8_dfa<T>::lead_mask[12];
+        template<typename T>
+        constexpr unsigned char utf8_dfa<T>::transitions[12 * 12];
+#endif
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+//! @endcond
+
+#endif
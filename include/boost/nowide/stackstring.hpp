@@ -9,8 +9,10 @@
 #define BOOST_NOWIDE_STACKSTRING_HPP_INCLUDED
 
 #include <boost/nowide/convert.hpp>
+#include <boost/nowide/detail/transcode.hpp>
 #include <boost/nowide/utf/utf.hpp>
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 
 namespace boost {
@@ -91,9 +93,20 @@ namespace nowide {
         /// If input is NULL, the current buffer will be reset to NULL
         output_char* convert(const input_char* input)
         {
-            if(input)
-                return convert(input, input + utf::strlen(input));
             clear();
+
+            if(input)
+            {
+                // The end of the input is found while converting it, only the rest is measured if it doesn't fit
+                const input_char* in = input;
+                output_char* out = buffer_;
+                std::size_t replacements = 0;
+                if(detail::transcode_terminated(in, out, buffer_ + buffer_size - 1, replacements, utf::replace_t())
+                   == detail::transcode_status::complete)
+                    store_on_stack(out);
+                else
+                    continue_on_heap(in, in + detail::string_length(in), out);
+            }
             return get();
         }
         /// Convert the sequence [begin, end) and store in internal buffer
@@ -104,22 +117,12 @@ namespace nowide {
 
             if(begin)
             {
-                const size_t input_len = end - begin;
-                // Minimum size required: 1 output char per input char + trailing NULL
-                const size_t min_output_size = input_len + 1;
-                // If there is a chance the converted string fits on stack, try it
-                if(min_output_size <= buffer_size && utf::convert_buffer(buffer_, buffer_size, begin, end))
-                    data_ = buffer_;
+                const input_char* in = begin;
+                output_char* out = buffer_;
+                if(detail::transcode(in, end, out, buffer_ + buffer_size - 1))
+                    store_on_stack(out);
                 else
-                {
-                    // Fallback: Allocate a buffer that is surely large enough on heap
-                    // Max size: Every input char is transcoded to the output char with maximum with + trailing NULL
-                    const size_t max_output_size = input_len * utf::utf_traits<output_char>::max_width + 1;
-                    data_ = new output_char[max_output_size];
-                    const bool success = utf::convert_buffer(data_, max_output_size, begin, end) == data_;
-                    assert(success);
-                    (void)success;
-                }
+                    continue_on_heap(in, end, out);
             }
             return get();
         }
@@ -185,6 +188,28 @@ namespace nowide {
         }
 
     private:
+        /// Use the stack buffer holding the complete result ending at \a out
+        void store_on_stack(output_char* out)
+        {
+            *out = 0;
+            data_ = buffer_;
+        }
+        /// Continue the conversion of [in, end) which didn't fit into the stack buffer (filled up to \a out)
+        /// on the heap. Its size is an upper bound computed from the remaining input, so no separate pass is required
+        void continue_on_heap(const input_char* in, const input_char* end, output_char* out)
+        {
+            const std::size_t written = static_cast<std::size_t>(out - buffer_);
+            const std::size_t max_size =
+              written + detail::max_growth<output_char, input_char>::value * static_cast<std::size_t>(end - in);
+            data_ = new output_char[max_size + 1];
+            std::memcpy(data_, buffer_, sizeof(output_char) * written);
+            out = data_ + written;
+            const bool success = detail::transcode(in, end, out, data_ + max_size);
+            assert(success);
+            (void)success;
+            *out = 0;
+        }
+
         output_char buffer_[buffer_size];
         output_char* data_;
     }; // basic_stackstring
@@ -205,6 +230,16 @@ namespace nowide {
     /// Convenience typedef
     ///
     using short_stackstring = basic_stackstring<char, wchar_t, 16>;
+#ifdef __cpp_lib_char8_t
+    ///
+    /// Convenience typedef, the input may also be converted from UTF-8 using `basic_stackstring<wchar_t, char8_t>`
+    ///
+    using u8stackstring = basic_stackstring<char8_t, wchar_t, 256>;
+    ///
+    /// Convenience typedef
+    ///
+    using u8short_stackstring = basic_stackstring<char8_t, wchar_t, 16>;
+#endif
 
 } // namespace nowide
 } // namespace boost
@@ -0,0 +1,405 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_UTF_CODEPAGE_HPP_INCLUDED
+#define BOOST_NOWIDE_UTF_CODEPAGE_HPP_INCLUDED
+
+#include <boost/nowide/detail/kernels_codepage.hpp>
+#include <boost/nowide/detail/transcode.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace boost {
+namespace nowide {
+    namespace utf {
+
+        ///
+        /// \brief Code unit of text encoded in ISO-8859-1 (Latin-1)
+        ///
+        /// A distinct type for the bytes of such text so it can be passed to the conversion functions like
+        /// utf::convert_string or utf::convert_buffer, e.g. after reading a file:
+        /// `utf::convert_string<char>(reinterpret_cast<const utf::latin1_char*>(s.data()), ...)`.
+        /// Each byte is the code point of the same value.
+        ///
+        enum latin1_char : unsigned char
+        {
+        };
+
+        ///
+        /// \brief Code unit of text encoded in Windows-1252, the Western European codepage of Windows
+        ///
+        /// Like latin1_char, except that the bytes 0x80-0x9F map to typographic characters like U+20AC (Euro sign)
+        /// as specified by the WHATWG Encoding Standard, i.e. including the 5 bytes undefined in Windows-1252
+        /// which map to the C1 control characters of the same value.
+        ///
+        enum cp1252_char : unsigned char
+        {
+        };
+
+    } // namespace utf
+
+    namespace detail {
+        //! @cond Doxygen_Suppress
+
+        /// Code points of the bytes 0x80-0x9F of Windows-1252
+        template<typename T = void>
+        struct cp1252_table
+        {
+            static constexpr std::uint16_t code_points[32] = {
+              0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, // 80-87
+              0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F, // 88-8F
+              0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, // 90-97
+              0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178, // 98-9F
+            };
+        };
+#ifndef __cpp_inline_variables
+        template<typename T>
+        constexpr std::uint16_t cp1252_table<T>::code_points[32];
+#endif
+
+        /// Latin-1: All bytes map to the code point of the same value
+        struct latin1_charset
+        {
+            static const unsigned identity_begin = 0x80;
+            static BOOST_CXX14_CONSTEXPR utf::code_point to_code_point(const unsigned char c)
+            {
+                return c;
+            }
+            static BOOST_CXX14_CONSTEXPR int from_code_point(const utf::code_point c)
+            {
+                return (c <= 0xFF) ? static_cast<int>(c) : -1;
+            }
+        };
+
+        /// Windows-1252: The bytes 0x80-0x9F are looked up in cp1252_table, all others are the same code point
+        struct cp1252_charset
+        {
+            static const unsigned identity_begin = 0xA0;
+            static BOOST_CXX14_CONSTEXPR utf::code_point to_code_point(const unsigned char c)
+            {
+                return (c < 0x80 || c >= identity_begin) ? c : cp1252_table<>::code_points[c - 0x80];
+            }
+            static BOOST_CXX14_CONSTEXPR int from_code_point(const utf::code_point c)
+            {
+                if(c < 0x80 || (c >= identity_begin && c <= 0xFF))
+                    return static_cast<int>(c);
+                for(unsigned i = 0; i < 32; i++)
+                {
+                    if(cp1252_table<>::code_points[i] == c)
+                        return static_cast<int>(0x80 + i);
+                }
+                return -1;
+            }
+        };
+
+        /// utf_traits of a single byte codepage described by \a Charset.
+        /// Every byte is a complete code point, so decoding never fails.
+        /// Code points which can't be represented are encoded as '?'.
+        /// The conversion functions check them with can_encode first and handle them like invalid sequences.
+        template<typename CharType, typename Charset>
+        struct codepage_traits
+        {
+            using char_type = CharType;
+            /// Bytes from this value up to 0xFF are the code points of the same value, used by the bulk kernels
+            static const unsigned identity_begin = Charset::identity_begin;
+
+            static BOOST_CXX14_CONSTEXPR int trail_length(char_type /*c*/)
+            {
+                return 0;
+            }
+            static BOOST_CXX14_CONSTEXPR bool is_trail(char_type /*c*/)
+            {
+                return false;
+            }
+            static BOOST_CXX14_CONSTEXPR bool is_lead(char_type /*c*/)
+            {
+                return true;
+            }
+
+            template<typename It>
+            static BOOST_CXX14_CONSTEXPR utf::code_point decode_valid(It& current)
+            {
+                return Charset::to_code_point(static_cast<unsigned char>(*current++));
+            }
+            template<typename It>
+            static BOOST_CXX14_CONSTEXPR utf::code_point decode(It& current, It last)
+            {
+                if(BOOST_UNLIKELY(current == last))
+                    return utf::incomplete;
+                return decode_valid(current);
+            }
+
+            static const int max_width = 1;
+            static BOOST_CXX14_CONSTEXPR int width(utf::code_point /*u*/)
+            {
+                return 1;
+            }
+            static BOOST_CXX14_CONSTEXPR bool can_encode(utf::code_point u)
+            {
+                return Charset::from_code_point(u) >= 0;
+            }
+            template<typename It>
+            static BOOST_CXX14_CONSTEXPR It encode(utf::code_point u, It out)
+            {
+                const int c = Charset::from_code_point(u);
+                *out++ = static_cast<char_type>(c >= 0 ? c : '?');
+                return out;
+            }
+        };
+
+        template<>
+        struct code_unit_size<utf::latin1_char> : std::integral_constant<int, 0>
+        {};
+        template<>
+        struct code_unit_size<utf::cp1252_char> : std::integral_constant<int, 0>
+        {};
+
+        template<typename CharOut>
+        struct encodable<CharOut, 0>
+        {
+            static BOOST_CXX14_CONSTEXPR bool check(utf::code_point c)
+            {
+                return utf::utf_traits<CharOut>::can_encode(c);
+            }
+        };
+
+        //! @endcond
+    } // namespace detail
+
+    namespace utf {
+
+        /// Traits of Latin-1 text, see latin1_char
+        template<>
+        struct utf_traits<latin1_char, 1> : detail::codepage_traits<latin1_char, detail::latin1_charset>
+        {};
+
+        /// Traits of Windows-1252 text, see cp1252_char
+        template<>
+        struct utf_traits<cp1252_char, 1> : detail::codepage_traits<cp1252_char, detail::cp1252_charset>
+        {};
+
+    } // namespace utf
+
+    namespace detail {
+        //! @cond Doxygen_Suppress
+
+        /// Codepage -> UTF-16/32
+        template<typename CharOut, typename CharIn>
+        struct codepage_to_wide_kernels
+        {
+            using kernel = bulk_kernel<CharOut, CharIn>;
+            static const unsigned identity_begin = utf::utf_traits<CharIn>::identity_begin;
+            template<typename Kernel>
+            static void call(Kernel kernel, const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+                kernel(p, reinterpret_cast<const unsigned char*>(in_end), out, out_end);
+                in = reinterpret_cast<const CharIn*>(p);
+            }
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+            static void run_sse2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&sse2::codepage_to_wide<identity_begin, CharOut>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+            static void run_avx2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&avx2::codepage_to_wide<identity_begin, CharOut>, in, in_end, out, out_end);
+            }
+#endif
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &run_avx2;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &run_sse2;
+#endif
+                (void)isa;
+                return &no_bulk_kernel<CharOut, CharIn>;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 2, 0>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                active_kernel<codepage_to_wide_kernels<CharOut, CharIn>>()(in, in_end, out, out_end);
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 4, 0> : bulk_transcoder<CharOut, CharIn, 2, 0>
+        {};
+
+        /// UTF-16/32 -> codepage
+        template<typename CharOut, typename CharIn>
+        struct wide_to_codepage_kernels
+        {
+            using kernel = bulk_kernel<CharOut, CharIn>;
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+            static void run_sse2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                unsigned char* o = reinterpret_cast<unsigned char*>(out);
+                sse2::wide_to_codepage<utf::utf_traits<CharOut>::identity_begin>(
+                  in, in_end, o, reinterpret_cast<unsigned char*>(out_end));
+                out = reinterpret_cast<CharOut*>(o);
+            }
+#endif
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &run_sse2;
+#endif
+                (void)isa;
+                return &no_bulk_kernel<CharOut, CharIn>;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 0, 2>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                active_kernel<wide_to_codepage_kernels<CharOut, CharIn>>()(in, in_end, out, out_end);
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 0, 4> : bulk_transcoder<CharOut, CharIn, 0, 2>
+        {};
+
+        /// Codepage -> UTF-8, without SIMD instructions only the ASCII prefix is copied
+        template<typename CharOut, typename CharIn>
+        struct codepage_to_utf8_kernels
+        {
+            using kernel = bulk_kernel<CharOut, CharIn>;
+            static const unsigned identity_begin = utf::utf_traits<CharIn>::identity_begin;
+            template<typename Kernel>
+            static void call(Kernel kernel, const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+                unsigned char* o = reinterpret_cast<unsigned char*>(out);
+                kernel(p, reinterpret_cast<const unsigned char*>(in_end), o, reinterpret_cast<unsigned char*>(out_end));
+                in = reinterpret_cast<const CharIn*>(p);
+                out = reinterpret_cast<CharOut*>(o);
+            }
+            static void scalar(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                copy_ascii_prefix(in, in_end, out, out_end);
+            }
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+            static void run_sse2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&sse2::codepage_to_utf8<identity_begin>, in, in_end, out, out_end);
+            }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+            static void run_avx2(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                call(&avx2::codepage_to_utf8<identity_begin>, in, in_end, out, out_end);
+            }
+#endif
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_AVX2
+                if(isa >= simd_isa::avx2)
+                    return &run_avx2;
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &run_sse2;
+#endif
+                (void)isa;
+                return &scalar;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 1, 0>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                active_kernel<codepage_to_utf8_kernels<CharOut, CharIn>>()(in, in_end, out, out_end);
+            }
+        };
+
+        /// UTF-8 -> codepage and between codepages: Only ASCII is the same in both encodings
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 0, 1>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, CharOut*& out, CharOut* out_end)
+            {
+                copy_ascii_prefix(in, in_end, out, out_end);
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_transcoder<CharOut, CharIn, 0, 0> : bulk_transcoder<CharOut, CharIn, 0, 1>
+        {};
+
+        /// Codepage -> UTF-16/32 length: One code unit per byte
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 2, 0>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                length += static_cast<std::size_t>(in_end - in);
+                in = in_end;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 4, 0> : bulk_counter<CharOut, CharIn, 2, 0>
+        {};
+
+        /// Codepage -> UTF-8 length
+        template<typename CharIn>
+        struct codepage_utf8_length_kernels
+        {
+            using kernel = void (*)(const CharIn*& in, const CharIn* in_end, std::size_t& length);
+            static void scalar(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                const CharIn* p = ascii_prefix(in, in_end);
+                length += static_cast<std::size_t>(p - in);
+                in = p;
+            }
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+            static void run_sse2(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+                sse2::codepage_utf8_length<utf::utf_traits<CharIn>::identity_begin>(
+                  p, reinterpret_cast<const unsigned char*>(in_end), length);
+                in = reinterpret_cast<const CharIn*>(p);
+            }
+#endif
+            static kernel select(const simd_isa isa)
+            {
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+                if(isa >= simd_isa::sse2)
+                    return &run_sse2;
+#endif
+                (void)isa;
+                return &scalar;
+            }
+        };
+        template<typename CharOut, typename CharIn>
+        struct bulk_counter<CharOut, CharIn, 1, 0>
+        {
+            static void run(const CharIn*& in, const CharIn* in_end, std::size_t& length)
+            {
+                active_kernel<codepage_utf8_length_kernels<CharIn>>()(in, in_end, length);
+            }
+        };
+
+        //! @endcond
+    } // namespace detail
+
+} // namespace nowide
+} // namespace boost
+
+#endif
@@ -0,0 +1,181 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_UTF_CODEPOINT_INDEX_HPP_INCLUDED
+#define BOOST_NOWIDE_UTF_CODEPOINT_INDEX_HPP_INCLUDED
+
+#include <boost/nowide/detail/is_string_container.hpp>
+#include <boost/nowide/detail/kernels_count.hpp>
+#include <boost/nowide/detail/kernels_validate.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        //! @cond Doxygen_Suppress
+
+        /// Minimum number of code units counted at once by utf::codepoint_index::append
+        static const std::size_t min_index_block_size = 256;
+
+        //! @endcond
+    } // namespace detail
+
+    namespace utf {
+
+        ///
+        /// \brief Sparse index of the code point positions of a (growing) UTF text for random access by code point
+        ///
+        /// Records the offset (in code units) of every interval()-th code point, so the offset of any code point
+        /// is found by scanning at most interval() code points from the closest checkpoint
+        /// and the code point at an offset by a binary search of the checkpoints.
+        /// The index doesn't hold the text, it has to be passed to the lookups and may be moved in between,
+        /// e.g. when a std::string is reallocated while appending.
+        ///
+        /// Code points are counted like count_codepoints does, i.e. each code unit which is not a trail
+        /// (a UTF-8 continuation byte or a UTF-16 low surrogate) starts a code point.
+        /// For valid UTF these are exactly the decoded code points.
+        ///
+        template<typename CharIn>
+        class codepoint_index
+        {
+            using traits = utf_traits<CharIn>;
+
+        public:
+            /// Create an empty index with a checkpoint every \a interval code points
+            explicit codepoint_index(size_t interval = 1024) : interval_(interval), num_code_points_(0), num_units_(0)
+            {
+                assert(interval > 0);
+            }
+            /// Create an index of the text [begin, end)
+            codepoint_index(const CharIn* begin, const CharIn* end, size_t interval = 1024) :
+                codepoint_index(interval)
+            {
+                append(begin, end);
+            }
+
+            /// Extend the index by the text [begin, end) appended to the indexed text.
+            ///
+            /// The text is counted in blocks using SIMD instructions where available,
+            /// only blocks containing a checkpoint are scanned per code unit.
+            /// The text may be appended in arbitrary chunks, even splitting a sequence.
+            void append(const CharIn* begin, const CharIn* end)
+            {
+                const size_t block_size = (std::max)(interval_, detail::min_index_block_size);
+                const CharIn* p = begin;
+                while(p != end)
+                {
+                    const CharIn* const block_end = p + (std::min)(block_size, static_cast<size_t>(end - p));
+                    const size_t count = count_code_points(p, block_end);
+                    // First code point without a checkpoint, i.e. the next one to record
+                    const size_t next_checkpoint = checkpoints_.size() * interval_;
+                    if(num_code_points_ + count <= next_checkpoint)
+                        num_code_points_ += count;
+                    else
+                        scan(begin, p, block_end);
+                    p = block_end;
+                }
+                num_units_ += static_cast<size_t>(end - begin);
+            }
+
+            /// Remove all entries so the index can be used for a new text
+            void clear()
+            {
+                checkpoints_.clear();
+                num_code_points_ = 0;
+                num_units_ = 0;
+            }
+
+            /// Number of code points in the indexed text
+            size_t size() const
+            {
+                return num_code_points_;
+            }
+            /// Number of code units in the indexed text
+            size_t units() const
+            {
+                return num_units_;
+            }
+            /// Number of code points between the checkpoints
+            size_t interval() const
+            {
+                return interval_;
+            }
+
+            /// Return the offset (in code units) of code point \a n in the indexed \a text,
+            /// which is units() for `n == size()`
+            size_t offset(const CharIn* text, size_t n) const
+            {
+                assert(n <= num_code_points_);
+                if(n == num_code_points_)
+                    return num_units_;
+                size_t pos = checkpoints_[n / interval_];
+                for(size_t remaining = n % interval_; remaining > 0;)
+                {
+                    if(!traits::is_trail(text[++pos]))
+                        --remaining;
+                }
+                return pos;
+            }
+
+            /// Return the index of the code point containing the code unit at \a offset (< units()) in \a text
+            size_t code_point_at(const CharIn* text, size_t offset) const
+            {
+                assert(offset < num_units_);
+                const auto next = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), offset);
+                // Trails before the first code point belong to it
+                if(next == checkpoints_.begin())
+                    return 0;
+                const size_t checkpoint = static_cast<size_t>(next - checkpoints_.begin()) - 1;
+                const CharIn* const begin = text + *(next - 1) + 1;
+                return checkpoint * interval_ + count_code_points(begin, text + offset + 1);
+            }
+
+        private:
+            static size_t count_code_points(const CharIn* begin, const CharIn* end)
+            {
+                return detail::count_code_points(begin, end, detail::code_unit_size<CharIn>());
+            }
+
+            /// Count the code points in [p, end) one by one, recording the checkpoints.
+            /// \a chunk is the start of the chunk passed to append
+            void scan(const CharIn* chunk, const CharIn* p, const CharIn* end)
+            {
+                for(; p != end; ++p)
+                {
+                    if(traits::is_trail(*p))
+                        continue;
+                    if(num_code_points_ == checkpoints_.size() * interval_)
+                        checkpoints_.push_back(num_units_ + static_cast<size_t>(p - chunk));
+                    ++num_code_points_;
+                }
+            }
+
+            size_t interval_;
+            size_t num_code_points_;
+            size_t num_units_;
+            /// Offset of every interval_-th code point
+            std::vector<size_t> checkpoints_;
+        };
+
+        /// Return a codepoint_index of the string \a s with a checkpoint every \a interval code points
+        template<typename StringOrStringView, typename = detail::requires_string_container<StringOrStringView>>
+        codepoint_index<typename StringOrStringView::value_type> make_codepoint_index(const StringOrStringView& s,
+                                                                                      size_t interval = 1024)
+        {
+            return codepoint_index<typename StringOrStringView::value_type>(s.data(), s.data() + s.size(), interval);
+        }
+
+    } // namespace utf
+} // namespace nowide
+} // namespace boost
+
+#endif
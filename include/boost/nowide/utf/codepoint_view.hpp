@@ -0,0 +1,284 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_UTF_CODEPOINT_VIEW_HPP_INCLUDED
+#define BOOST_NOWIDE_UTF_CODEPOINT_VIEW_HPP_INCLUDED
+
+#include <boost/nowide/detail/is_string_container.hpp>
+#include <boost/nowide/detail/kernels_validate.hpp>
+#include <boost/nowide/replacement.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <cstddef>
+#include <iterator>
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        //! @cond Doxygen_Suppress
+
+        /// Decode the code point starting at \a p (!= end) and set \a next to the start of the following one.
+        /// An invalid sequence is decoded as the replacement character consisting of only the code unit at \a p,
+        /// so every code unit which is not part of a valid sequence is a code point of its own.
+        template<typename CharIn>
+        utf::code_point decode_code_point_at(const CharIn* p, const CharIn* end, const CharIn*& next)
+        {
+            if(is_ascii_unit(*p))
+            {
+                next = p + 1;
+                return static_cast<utf::code_point>(*p);
+            }
+            next = p;
+            const utf::code_point c = utf::utf_traits<CharIn>::decode(next, end);
+            if(c == utf::illegal || c == utf::incomplete)
+            {
+                next = p + 1;
+                return BOOST_NOWIDE_REPLACEMENT_CHARACTER;
+            }
+            return c;
+        }
+
+        /// Return the start of the code point ending at \a p (!= begin) as defined by decode_code_point_at.
+        ///
+        /// As valid sequences start with a lead code unit followed by trail units only,
+        /// it is the closest preceding lead if the sequence starting there is valid and ends at \a p,
+        /// otherwise the code unit before \a p is a code point of its own.
+        template<typename CharIn>
+        const CharIn* previous_code_point(const CharIn* begin, const CharIn* p)
+        {
+            using traits = utf::utf_traits<CharIn>;
+            const CharIn* const last = p - 1;
+            if(is_ascii_unit(*last))
+                return last;
+            for(const CharIn* lead = last;; --lead)
+            {
+                if(!traits::is_trail(*lead))
+                {
+                    const CharIn* next = lead;
+                    const utf::code_point c = traits::decode(next, p);
+                    return (c != utf::illegal && c != utf::incomplete && next == p) ? lead : last;
+                }
+                if(lead == begin || p - lead >= traits::max_width)
+                    return last;
+            }
+        }
+
+        //! @endcond
+    } // namespace detail
+
+    namespace utf {
+
+        ///
+        /// \brief Bidirectional iterator over the code points of a range of UTF code units, see codepoint_view
+        ///
+        /// Dereferencing decodes the code point at the current position, the input is never modified or copied.
+        /// Each code unit which is not part of a valid sequence is a code point of its own
+        /// and yields the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER.
+        /// This makes the decoding independent of the direction, so e.g. a delimiter following
+        /// an incomplete sequence is always found. (The conversion functions replace such a sequence
+        /// including the following unit by a single replacement character.)
+        ///
+        template<typename CharIn>
+        class codepoint_iterator
+        {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = code_point;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const code_point*;
+            using reference = code_point;
+
+            codepoint_iterator() : begin_(nullptr), pos_(nullptr), end_(nullptr)
+            {}
+            /// Iterator at \a pos which must be the start of a code point of the range [begin, end)
+            codepoint_iterator(const CharIn* begin, const CharIn* pos, const CharIn* end) :
+                begin_(begin), pos_(pos), end_(end)
+            {}
+
+            /// Position of the current code point in the underlying range
+            const CharIn* base() const
+            {
+                return pos_;
+            }
+
+            code_point operator*() const
+            {
+                const CharIn* next;
+                return detail::decode_code_point_at(pos_, end_, next);
+            }
+            codepoint_iterator& operator++()
+            {
+                if(detail::is_ascii_unit(*pos_))
+                    ++pos_;
+                else
+                    detail::decode_code_point_at(pos_, end_, pos_);
+                return *this;
+            }
+            codepoint_iterator operator++(int)
+            {
+                codepoint_iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+            codepoint_iterator& operator--()
+            {
+                pos_ = detail::previous_code_point(begin_, pos_);
+                return *this;
+            }
+            codepoint_iterator operator--(int)
+            {
+                codepoint_iterator tmp = *this;
+                --*this;
+                return tmp;
+            }
+
+            /// Advance past all ASCII code points at the current position, searching them in blocks
+            /// using SIMD instructions where available. Useful when only non-ASCII code points need to be handled.
+            codepoint_iterator& skip_ascii()
+            {
+                pos_ = detail::ascii_prefix(pos_, end_);
+                while(pos_ != end_ && detail::is_ascii_unit(*pos_))
+                    ++pos_;
+                return *this;
+            }
+
+            friend bool operator==(const codepoint_iterator& lhs, const codepoint_iterator& rhs)
+            {
+                return lhs.pos_ == rhs.pos_;
+            }
+            friend bool operator!=(const codepoint_iterator& lhs, const codepoint_iterator& rhs)
+            {
+                return lhs.pos_ != rhs.pos_;
+            }
+
+        private:
+            const CharIn* begin_;
+            const CharIn* pos_;
+            const CharIn* end_;
+        };
+
+        ///
+        /// \brief View of the code points of a range of UTF-8, UTF-16 or UTF-32 code units
+        ///
+        /// Decodes lazily while iterating (in both directions) without allocating memory,
+        /// see codepoint_iterator for the handling of invalid sequences.
+        ///
+        template<typename CharIn>
+        class codepoint_view
+        {
+        public:
+            using iterator = codepoint_iterator<CharIn>;
+            using const_iterator = iterator;
+            using reverse_iterator = std::reverse_iterator<iterator>;
+            using const_reverse_iterator = reverse_iterator;
+
+            /// View of the code points in the range [begin, end)
+            codepoint_view(const CharIn* begin, const CharIn* end) : begin_(begin), end_(end)
+            {}
+
+            iterator begin() const
+            {
+                return iterator(begin_, begin_, end_);
+            }
+            iterator end() const
+            {
+                return iterator(begin_, end_, end_);
+            }
+            reverse_iterator rbegin() const
+            {
+                return reverse_iterator(end());
+            }
+            reverse_iterator rend() const
+            {
+                return reverse_iterator(begin());
+            }
+            bool empty() const
+            {
+                return begin_ == end_;
+            }
+
+        private:
+            const CharIn* begin_;
+            const CharIn* end_;
+        };
+
+        /// Return a codepoint_view of the range [begin, end)
+        template<typename CharIn>
+        codepoint_view<CharIn> make_codepoint_view(const CharIn* begin, const CharIn* end)
+        {
+            return codepoint_view<CharIn>(begin, end);
+        }
+        /// Return a codepoint_view of the string \a s, which must outlive the view
+        template<typename StringOrStringView, typename = detail::requires_string_container<StringOrStringView>>
+        codepoint_view<typename StringOrStringView::value_type> make_codepoint_view(const StringOrStringView& s)
+        {
+            return codepoint_view<typename StringOrStringView::value_type>(s.data(), s.data() + s.size());
+        }
+
+        ///
+        /// \brief Output iterator encoding each code point assigned to it as \a CharOut
+        /// to the iterator \a OutputIterator
+        ///
+        /// E.g. `std::copy(view.begin(), view.end(), utf::make_encode_iterator<wchar_t>(out))` transcodes
+        /// a codepoint_view without intermediate buffers.
+        /// Invalid code points (surrogates or above U+10FFFF) are encoded as the replacement character,
+        /// see #BOOST_NOWIDE_REPLACEMENT_CHARACTER.
+        ///
+        template<typename CharOut, typename OutputIterator>
+        class encode_iterator
+        {
+        public:
+            using iterator_category = std::output_iterator_tag;
+            using value_type = void;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = void;
+
+            explicit encode_iterator(OutputIterator out) : out_(out)
+            {}
+
+            /// Return the underlying iterator, positioned after the code units written so far
+            OutputIterator base() const
+            {
+                return out_;
+            }
+
+            encode_iterator& operator=(code_point c)
+            {
+                if(!is_valid_codepoint(c))
+                    c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
+                out_ = utf_traits<CharOut>::encode(c, out_);
+                return *this;
+            }
+            encode_iterator& operator*()
+            {
+                return *this;
+            }
+            encode_iterator& operator++()
+            {
+                return *this;
+            }
+            encode_iterator& operator++(int)
+            {
+                return *this;
+            }
+
+        private:
+            OutputIterator out_;
+        };
+
+        /// Return an encode_iterator writing \a CharOut code units to \a out
+        template<typename CharOut, typename OutputIterator>
+        encode_iterator<CharOut, OutputIterator> make_encode_iterator(OutputIterator out)
+        {
+            return encode_iterator<CharOut, OutputIterator>(out);
+        }
+
+    } // namespace utf
+} // namespace nowide
+} // namespace boost
+
+#endif
@@ -10,25 +10,92 @@
 #define BOOST_NOWIDE_UTF_CONVERT_HPP_INCLUDED
 
 #include <boost/nowide/detail/is_string_container.hpp>
+#include <boost/nowide/detail/transcode.hpp>
 #include <boost/nowide/replacement.hpp>
+#include <boost/nowide/utf/error_policy.hpp>
 #include <boost/nowide/utf/utf.hpp>
-#include <iterator>
+#include <cstddef>
 #include <string>
+#include <type_traits>
 
 namespace boost {
 namespace nowide {
+    namespace detail {
+        //! @cond Doxygen_Suppress
+
+        /// Return the kind of the error at \a p where a conversion of [p, end) stopped:
+        /// utf::incomplete or utf::illegal, which includes a valid code point the output can't represent
+        template<typename CharIn>
+        utf::code_point error_kind(const CharIn* p, const CharIn* end)
+        {
+            return (utf::utf_traits<CharIn>::decode(p, end) == utf::incomplete) ? utf::incomplete : utf::illegal;
+        }
+
+        /// Throw a utf::conversion_error for the invalid sequence at \a p of the input [begin, end)
+        template<typename CharIn>
+        void throw_conversion_error(const CharIn* begin, const CharIn* p, const CharIn* end)
+        {
+            throw utf::conversion_error(static_cast<size_t>(p - begin), error_kind(p, end));
+        }
+
+        /// Append the conversion of [begin, end) to \a output which requires at most \a size code units.
+        /// With utf::strict a utf::conversion_error is thrown for an invalid sequence and \a output is unchanged.
+        template<typename CharOut, typename CharIn, typename Policy>
+        void append_transcoded(std::basic_string<CharOut>& output,
+                               const CharIn* begin,
+                               const CharIn* end,
+                               size_t size,
+                               Policy policy)
+        {
+            const size_t offset = output.size();
+            const CharIn* in = begin;
+            size_t replacements = 0;
+#ifdef __cpp_lib_string_resize_and_overwrite
+            output.resize_and_overwrite(offset + size, [&in, end, offset, &replacements, policy](CharOut* buffer,
+                                                                                                   size_t buffer_size) {
+                CharOut* out = buffer + offset;
+                transcode(in, end, out, buffer + buffer_size, replacements, policy);
+                return static_cast<size_t>(out - buffer);
+            });
+#else
+            output.resize(offset + size);
+            CharOut* const buffer = &output[0];
+            CharOut* out = buffer + offset;
+            transcode(in, end, out, buffer + offset + size, replacements, policy);
+            output.resize(static_cast<size_t>(out - buffer));
+#endif
+            // Only possible with utf::strict as size is sufficient otherwise
+            if(in != end)
+            {
+                output.resize(offset);
+                throw_conversion_error(begin, in, end);
+            }
+        }
+
+        //! @endcond
+    } // namespace detail
+
     namespace utf {
 
         /// Return the length of the given string in code units.
         /// That is the number of elements of type Char until the first NULL character.
-        /// Equivalent to `std::strlen(s)` but can handle wide-strings
+        /// Equivalent to `std::strlen(s)` (which is used for `char`) but can handle wide-strings,
+        /// searching them for the terminator in blocks using SIMD instructions
         template<typename Char>
-        size_t strlen(const Char* s)
+        BOOST_CXX14_CONSTEXPR size_t strlen(const Char* s)
         {
+#ifdef BOOST_NO_CXX14_CONSTEXPR
+            return detail::string_length(s);
+#else
+#ifdef BOOST_NOWIDE_IS_CONSTANT_EVALUATED
+            if(!BOOST_NOWIDE_IS_CONSTANT_EVALUATED())
+                return detail::string_length(s);
+#endif
             const Char* end = s;
             while(*end)
                 end++;
             return end - s;
+#endif
         }
 
         /// Convert a buffer of UTF sequences in the range [source_begin, source_end)
@@ -37,59 +104,355 @@ namespace nowide {
         /// \return original buffer containing the NULL terminated string or NULL
         ///
         /// If there is not enough room in the buffer NULL is returned, and the content of the buffer is undefined.
-        /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+        /// Invalid sequences are handled according to the error \a policy:
+        /// With #replace, used by the overload without a policy, they are replaced with the replacement character,
+        /// see #BOOST_NOWIDE_REPLACEMENT_CHARACTER, with #strict a conversion_error is thrown.
+        /// Can be used in constant expressions if supported, see #BOOST_NOWIDE_CONSTEXPR_CONVERT
+        template<typename CharOut,
+                 typename CharIn,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        BOOST_NOWIDE_CONSTEXPR_CONVERT CharOut* convert_buffer(CharOut* buffer,
+                                                               size_t buffer_size,
+                                                               const CharIn* source_begin,
+                                                               const CharIn* source_end,
+                                                               Policy policy)
+        {
+            if(buffer_size == 0)
+                return nullptr;
+            CharOut* out = buffer;
+            const CharIn* in = source_begin;
+            size_t replacements = 0;
+            // Reserve space for the trailing NULL
+            const detail::transcode_status status =
+              detail::transcode(in, source_end, out, buffer + buffer_size - 1, replacements, policy);
+            *out = CharOut();
+            if(status == detail::transcode_status::invalid)
+                detail::throw_conversion_error(source_begin, in, source_end);
+            return status == detail::transcode_status::complete ? buffer : nullptr;
+        }
+        /// Same as above with the #replace error policy
         template<typename CharOut, typename CharIn>
-        CharOut*
+        BOOST_NOWIDE_CONSTEXPR_CONVERT CharOut*
         convert_buffer(CharOut* buffer, size_t buffer_size, const CharIn* source_begin, const CharIn* source_end)
         {
-            CharOut* rv = buffer;
+            return convert_buffer(buffer, buffer_size, source_begin, source_end, replace_t());
+        }
+
+        /// Convert the NULL terminated string \a source from \a CharIn to \a CharOut
+        /// to the output \a buffer of size \a buffer_size.
+        ///
+        /// Same as `convert_buffer(buffer, buffer_size, source, source + utf::strlen(source))`
+        /// but the terminator is searched during the conversion instead of in a separate pass.
+        /// \return original buffer containing the NULL terminated string or NULL
+        template<typename CharOut,
+                 typename CharIn,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        CharOut* convert_buffer(CharOut* buffer, size_t buffer_size, const CharIn* source, Policy policy)
+        {
             if(buffer_size == 0)
                 return nullptr;
-            buffer_size--;
-            while(source_begin != source_end)
+            CharOut* out = buffer;
+            const CharIn* in = source;
+            size_t replacements = 0;
+            // Reserve space for the trailing NULL
+            const detail::transcode_status status =
+              detail::transcode_terminated(in, out, buffer + buffer_size - 1, replacements, policy);
+            *out = CharOut();
+            if(status == detail::transcode_status::invalid)
+                detail::throw_conversion_error(source, in, in + strlen(in));
+            return status == detail::transcode_status::complete ? buffer : nullptr;
+        }
+        /// Same as above with the #replace error policy
+        template<typename CharOut, typename CharIn>
+        CharOut* convert_buffer(CharOut* buffer, size_t buffer_size, const CharIn* source)
+        {
+            return convert_buffer(buffer, buffer_size, source, replace_t());
+        }
+
+        /// \brief NULL terminated string of fixed capacity holding the result of convert_literal
+        ///
+        /// Its size is the number of code units excluding the trailing NULL.
+        template<typename Char, size_t Capacity>
+        class converted_literal
+        {
+        public:
+            /// Convert the UTF sequences in range [begin, end), the result must fit into Capacity - 1 code units
+            template<typename CharIn>
+            BOOST_CXX14_CONSTEXPR converted_literal(const CharIn* begin, const CharIn* end) : data_(), size_(0)
             {
-                code_point c = utf_traits<CharIn>::decode(source_begin, source_end);
-                if(c == illegal || c == incomplete)
-                {
-                    c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
-                }
-                size_t width = utf_traits<CharOut>::width(c);
-                if(buffer_size < width)
+                while(begin != end)
                 {
-                    rv = NULL;
-                    break;
+                    code_point c = utf_traits<CharIn>::decode(begin, end);
+                    if(c == illegal || c == incomplete)
+                        c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
+                    size_ = static_cast<size_t>(utf_traits<Char>::encode(c, data_ + size_) - data_);
                 }
-                buffer = utf_traits<CharOut>::encode(c, buffer);
-                buffer_size -= width;
             }
-            *buffer++ = 0;
-            return rv;
+
+            constexpr const Char* c_str() const
+            {
+                return data_;
+            }
+            constexpr const Char* data() const
+            {
+                return data_;
+            }
+            constexpr size_t size() const
+            {
+                return size_;
+            }
+            constexpr const Char* begin() const
+            {
+                return data_;
+            }
+            constexpr const Char* end() const
+            {
+                return data_ + size_;
+            }
+            constexpr Char operator[](size_t i) const
+            {
+                return data_[i];
+            }
+            /// Return a copy of the string
+            std::basic_string<Char> str() const
+            {
+                return std::basic_string<Char>(data_, size_);
+            }
+
+        private:
+            Char data_[Capacity];
+            size_t size_;
+        };
+
+        /// Convert the UTF sequences of the string literal \a s from \a CharIn to \a CharOut
+        /// and return them as a converted_literal with enough capacity for any input of that size.
+        ///
+        /// Is evaluated at compile time when used to initialize a constexpr variable (requires C++14),
+        /// e.g. `constexpr auto hello = utf::convert_literal<wchar_t>("Hello");`
+        /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+        /// \tparam CharOut Output character type
+        template<typename CharOut, typename CharIn, size_t N>
+        BOOST_CXX14_CONSTEXPR converted_literal<CharOut, (N - 1) * detail::max_growth<CharOut, CharIn>::value + 1>
+        convert_literal(const CharIn (&s)[N])
+        {
+            // Exclude the trailing NULL
+            return converted_literal<CharOut, (N - 1) * detail::max_growth<CharOut, CharIn>::value + 1>(s, s + N - 1);
+        }
+
+        /// Return the number of code units the conversion of the UTF sequences in range [begin, end)
+        /// from \a CharIn to \a CharOut results in, without writing them.
+        ///
+        /// Can be used to allocate the exact output size before converting.
+        /// Each invalid sequence counts as the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+        /// \tparam CharOut Output character type
+        template<typename CharOut, typename CharIn>
+        size_t output_length(const CharIn* begin, const CharIn* end)
+        {
+            return detail::output_length<CharOut>(begin, end);
+        }
+
+        /// Result of utf::convert
+        struct convert_result
+        {
+            /// Number of input code units converted
+            size_t consumed;
+            /// Number of code units written to the output
+            size_t written;
+            /// Number of code units required to convert the whole input, equal to \a written if it was
+            size_t required;
+            /// Number of invalid sequences in the whole input, which are replaced by the replacement character,
+            /// and of code points the output codepage can't represent, which are replaced by '?'
+            size_t replacements;
+            /// With the #strict error policy the kind (\ref illegal or \ref incomplete) of the first invalid sequence
+            /// in the input, 0 if there is none. The conversion stops before it, i.e. \a required only covers
+            /// the input up to that sequence which starts at \a consumed once \a written equals \a required.
+            /// A code point the output codepage can't represent is \ref illegal.
+            code_point error;
+
+            /// Return true if the whole input was converted
+            bool complete() const
+            {
+                return written == required && error == 0;
+            }
+        };
+
+        /// Convert a buffer of UTF sequences in the range [begin, end) from \a CharIn to \a CharOut
+        /// to the output buffer of size \a output_size (code units, no trailing NULL is written).
+        ///
+        /// Converts as many complete code points as fit into the output.
+        /// The remaining input can then be converted by calling this function again
+        /// with `begin + result.consumed` and a buffer of size `result.required - result.written`.
+        /// If \a output is NULL only the required size (and number of replacements) is computed.
+        ///
+        /// Invalid sequences are handled according to the error \a policy:
+        /// With #replace, used by the overload without a policy, they are replaced with the replacement character,
+        /// see #BOOST_NOWIDE_REPLACEMENT_CHARACTER, with #strict the conversion stops at the first one
+        /// and convert_result::error is set.
+        template<typename CharOut,
+                 typename CharIn,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        convert_result
+        convert(CharOut* output, size_t output_size, const CharIn* begin, const CharIn* end, Policy policy)
+        {
+            convert_result result = {0, 0, 0, 0, 0};
+            const CharIn* in = begin;
+            if(output)
+            {
+                CharOut* out = output;
+                detail::transcode(in, end, out, output + output_size, result.replacements, policy);
+                result.consumed = static_cast<size_t>(in - begin);
+                result.written = static_cast<size_t>(out - output);
+            }
+            result.required = result.written + detail::count_output<CharOut>(in, end, result.replacements, policy);
+            // Only possible with utf::strict
+            if(in != end)
+                result.error = detail::error_kind(in, end);
+            return result;
+        }
+        /// Same as above with the #replace error policy
+        template<typename CharOut, typename CharIn>
+        convert_result convert(CharOut* output, size_t output_size, const CharIn* begin, const CharIn* end)
+        {
+            return convert(output, output_size, begin, end, replace_t());
+        }
+
+        /// Convert the NULL terminated string \a source from \a CharIn to \a CharOut
+        /// to the output buffer of size \a output_size (code units, no trailing NULL is written).
+        ///
+        /// Same as `convert(output, output_size, source, source + utf::strlen(source))`
+        /// but the terminator is searched during the conversion instead of in a separate pass.
+        template<typename CharOut,
+                 typename CharIn,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        convert_result convert(CharOut* output, size_t output_size, const CharIn* source, Policy policy)
+        {
+            convert_result result = {0, 0, 0, 0, 0};
+            const CharIn* in = source;
+            if(output)
+            {
+                CharOut* out = output;
+                detail::transcode_terminated(in, out, output + output_size, result.replacements, policy);
+                result.consumed = static_cast<size_t>(in - source);
+                result.written = static_cast<size_t>(out - output);
+            }
+            result.required =
+              result.written + detail::count_output_terminated<CharOut>(in, result.replacements, policy);
+            // Only possible with utf::strict
+            if(*in != 0)
+                result.error = detail::error_kind(in, in + strlen(in));
+            return result;
+        }
+        /// Same as above with the #replace error policy
+        template<typename CharOut, typename CharIn>
+        convert_result convert(CharOut* output, size_t output_size, const CharIn* source)
+        {
+            return convert(output, output_size, source, replace_t());
+        }
+
+        /// Convert the UTF sequences in range [begin, end) from \a CharIn to \a CharOut
+        /// and append it to the string \a output
+        ///
+        /// The existing capacity of \a output is reused, memory is only allocated if it is too small.
+        /// The input must not point into \a output.
+        /// Invalid sequences are handled according to the error \a policy:
+        /// With #replace, used by the overload without a policy, they are replaced with the replacement character,
+        /// see #BOOST_NOWIDE_REPLACEMENT_CHARACTER, with #strict a conversion_error is thrown
+        /// and \a output is left unchanged.
+        /// \return \a output
+        template<typename CharOut,
+                 typename CharIn,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        std::basic_string<CharOut>& convert_append(std::basic_string<CharOut>& output,
+                                                   const CharIn* begin,
+                                                   const CharIn* end,
+                                                   Policy policy)
+        {
+            // Grow at most once and convert directly into the string
+            detail::append_transcoded(output, begin, end, detail::output_size<CharOut>(begin, end, policy), policy);
+            return output;
+        }
+        /// Same as above with the #replace error policy
+        template<typename CharOut, typename CharIn>
+        std::basic_string<CharOut>&
+        convert_append(std::basic_string<CharOut>& output, const CharIn* begin, const CharIn* end)
+        {
+            return convert_append(output, begin, end, replace_t());
+        }
+
+        /// Convert the NULL terminated string \a s from \a CharIn to \a CharOut and append it to the string \a output
+        ///
+        /// Same as `convert_append(output, s, s + utf::strlen(s))`
+        /// but the terminator is searched during the conversion instead of in a separate pass.
+        /// \return \a output
+        template<typename CharOut,
+                 typename CharIn,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        std::basic_string<CharOut>&
+        convert_append(std::basic_string<CharOut>& output, const CharIn* s, Policy policy)
+        {
+            const CharIn* end;
+            const size_t size = detail::output_size_terminated<CharOut>(s, end, policy);
+            detail::append_transcoded(output, s, end, size, policy);
+            return output;
+        }
+        /// Same as above with the #replace error policy
+        template<typename CharOut, typename CharIn>
+        std::basic_string<CharOut>& convert_append(std::basic_string<CharOut>& output, const CharIn* s)
+        {
+            return convert_append(output, s, replace_t());
         }
 
         /// Convert the UTF sequences in range [begin, end) from \a CharIn to \a CharOut
         /// and return it as a string
         ///
-        /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+        /// Invalid sequences are handled according to the error \a policy:
+        /// With #replace, used by the overload without a policy, they are replaced with the replacement character,
+        /// see #BOOST_NOWIDE_REPLACEMENT_CHARACTER, with #strict a conversion_error is thrown.
         /// \tparam CharOut Output character type
+        template<typename CharOut,
+                 typename CharIn,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        std::basic_string<CharOut> convert_string(const CharIn* begin, const CharIn* end, Policy policy)
+        {
+            std::basic_string<CharOut> result;
+            convert_append(result, begin, end, policy);
+            return result;
+        }
+        /// Same as above with the #replace error policy
         template<typename CharOut, typename CharIn>
         std::basic_string<CharOut> convert_string(const CharIn* begin, const CharIn* end)
+        {
+            return convert_string<CharOut>(begin, end, replace_t());
+        }
+
+        /// Convert the NULL terminated string \a s from \a CharIn to \a CharOut and return it as a string
+        ///
+        /// Same as `convert_string<CharOut>(s, s + utf::strlen(s))`
+        /// but the terminator is searched during the conversion instead of in a separate pass.
+        /// \tparam CharOut Output character type
+        template<typename CharOut,
+                 typename CharIn,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        std::basic_string<CharOut> convert_string(const CharIn* s, Policy policy)
         {
             std::basic_string<CharOut> result;
-            result.reserve(end - begin);
-            using inserter_type = std::back_insert_iterator<std::basic_string<CharOut>>;
-            inserter_type inserter(result);
-            code_point c;
-            while(begin != end)
-            {
-                c = utf_traits<CharIn>::decode(begin, end);
-                if(c == illegal || c == incomplete)
-                {
-                    c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
-                }
-                utf_traits<CharOut>::encode(c, inserter);
-            }
+            convert_append(result, s, policy);
             return result;
         }
+        /// Same as above with the #replace error policy
+        template<typename CharOut, typename CharIn>
+        std::basic_string<CharOut> convert_string(const CharIn* s)
+        {
+            return convert_string<CharOut>(s, replace_t());
+        }
 
     } // namespace utf
 } // namespace nowide
@@ -0,0 +1,204 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_UTF_CONVERT_BATCH_HPP_INCLUDED
+#define BOOST_NOWIDE_UTF_CONVERT_BATCH_HPP_INCLUDED
+
+#include <boost/nowide/detail/is_string_container.hpp>
+#include <boost/nowide/detail/transcode.hpp>
+#include <boost/nowide/utf/convert.hpp>
+#include <boost/nowide/utf/error_policy.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        //! @cond Doxygen_Suppress
+
+        /// Return the range of code units of the string container \a s
+        template<typename T, typename = requires_string_container<T>>
+        auto string_range(const T& s) -> std::pair<decltype(s.data()), decltype(s.data())>
+        {
+            return std::make_pair(s.data(), s.data() + s.size());
+        }
+        /// Return the range of code units of the NULL terminated string \a s
+        template<typename Char, typename = requires_char<Char>>
+        std::pair<const Char*, const Char*> string_range(const Char* s)
+        {
+            return std::make_pair(s, s + utf::strlen(s));
+        }
+
+        //! @endcond
+    } // namespace detail
+
+    namespace utf {
+
+        ///
+        /// \brief Converted strings stored back-to-back in a single buffer, see convert_batch
+        ///
+        /// Each string is followed by a NULL, so c_str(i) can be passed to C APIs
+        /// and buffer() has the layout of e.g. a Windows environment block (without the final NULL).
+        ///
+        template<typename Char>
+        class string_arena
+        {
+        public:
+            /// Create an empty arena
+            string_arena() : offsets_(1, 0)
+            {}
+
+            /// Convert the strings in the range [first, last) from their UTF character type to \a Char
+            /// and store them in this arena, replacing its content.
+            ///
+            /// The elements may be string containers (e.g. std::basic_string, std::basic_string_view)
+            /// or NULL terminated strings of any UTF character type, the range is traversed twice.
+            /// The existing capacity is reused, at most one allocation is done for the strings and one for the offsets.
+            /// Invalid sequences are handled according to the error \a policy:
+            /// With #replace, used by the overload without a policy, they are replaced with the replacement character,
+            /// see #BOOST_NOWIDE_REPLACEMENT_CHARACTER, with #strict a conversion_error with the offset
+            /// inside the invalid string is thrown and the arena only contains the strings before it, i.e. size()
+            /// is its index.
+            template<typename Iterator, typename Policy, typename = detail::requires_error_policy<Policy>>
+            void assign(Iterator first, Iterator last, Policy policy)
+            {
+                clear();
+                // Upper bound of the output size (exact where the output may grow), including the terminators
+                size_t capacity = 0;
+                size_t num_strings = 0;
+                for(Iterator it = first; it != last; ++it, ++num_strings)
+                {
+                    const auto s = detail::string_range(*it);
+                    capacity += detail::output_size<Char>(s.first, s.second, policy) + 1;
+                }
+                offsets_.reserve(num_strings + 1);
+
+                using range = decltype(detail::string_range(*first));
+                range invalid_string;
+                auto invalid_pos = invalid_string.first;
+                bool failed = false;
+                const auto convert_strings = [&](Char* buffer) {
+                    Char* out = buffer;
+                    for(Iterator it = first; it != last; ++it)
+                    {
+                        const range s = detail::string_range(*it);
+                        auto in = s.first;
+                        size_t replacements = 0;
+                        // Only fails with utf::strict as the capacity is sufficient otherwise
+                        if(detail::transcode(in, s.second, out, buffer + capacity, replacements, policy)
+                           != detail::transcode_status::complete)
+                        {
+                            invalid_string = s;
+                            invalid_pos = in;
+                            failed = true;
+                            break;
+                        }
+                        *out++ = 0;
+                        offsets_.push_back(static_cast<size_t>(out - buffer));
+                    }
+                    return offsets_.back();
+                };
+#ifdef __cpp_lib_string_resize_and_overwrite
+                buffer_.resize_and_overwrite(
+                  capacity, [&convert_strings](Char* buffer, size_t) { return convert_strings(buffer); });
+#else
+                buffer_.resize(capacity);
+                if(capacity != 0)
+                    buffer_.resize(convert_strings(&buffer_[0]));
+#endif
+                if(failed)
+                    detail::throw_conversion_error(invalid_string.first, invalid_pos, invalid_string.second);
+            }
+            /// Same as above with the #replace error policy
+            template<typename Iterator>
+            void assign(Iterator first, Iterator last)
+            {
+                assign(first, last, replace_t());
+            }
+
+            /// Remove all strings, keeping the capacity
+            void clear()
+            {
+                buffer_.clear();
+                offsets_.resize(1);
+            }
+
+            /// Number of strings
+            size_t size() const
+            {
+                return offsets_.size() - 1;
+            }
+            bool empty() const
+            {
+                return size() == 0;
+            }
+            /// Offset of the i-th string in buffer()
+            size_t offset(size_t i) const
+            {
+                return offsets_[i];
+            }
+            /// Length of the i-th string in code units excluding the trailing NULL
+            size_t length(size_t i) const
+            {
+                return offsets_[i + 1] - offsets_[i] - 1;
+            }
+            /// The NULL terminated i-th string
+            const Char* c_str(size_t i) const
+            {
+                return buffer_.c_str() + offsets_[i];
+            }
+            const Char* operator[](size_t i) const
+            {
+                return c_str(i);
+            }
+            /// Return a copy of the i-th string
+            std::basic_string<Char> str(size_t i) const
+            {
+                return std::basic_string<Char>(c_str(i), length(i));
+            }
+            /// All strings, each followed by a NULL
+            const std::basic_string<Char>& buffer() const
+            {
+                return buffer_;
+            }
+
+        private:
+            std::basic_string<Char> buffer_;
+            /// Offset of each string and the end of the last one
+            std::vector<size_t> offsets_;
+        };
+
+        /// Convert the strings in the range [first, last) to \a CharOut and return them in a string_arena
+        ///
+        /// Instead of allocating each converted string separately, they are stored back-to-back in a single buffer.
+        /// See string_arena::assign for the supported inputs and the error \a policy.
+        /// \tparam CharOut Output character type
+        template<typename CharOut,
+                 typename Iterator,
+                 typename Policy,
+                 typename = detail::requires_error_policy<Policy>>
+        string_arena<CharOut> convert_batch(Iterator first, Iterator last, Policy policy)
+        {
+            string_arena<CharOut> result;
+            result.assign(first, last, policy);
+            return result;
+        }
+        /// Same as above with the #replace error policy
+        template<typename CharOut, typename Iterator>
+        string_arena<CharOut> convert_batch(Iterator first, Iterator last)
+        {
+            return convert_batch<CharOut>(first, last, replace_t());
+        }
+
+    } // namespace utf
+} // namespace nowide
+} // namespace boost
+
+#endif
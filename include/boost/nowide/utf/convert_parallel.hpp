@@ -0,0 +1,204 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_UTF_CONVERT_PARALLEL_HPP_INCLUDED
+#define BOOST_NOWIDE_UTF_CONVERT_PARALLEL_HPP_INCLUDED
+
+#include <boost/nowide/detail/transcode.hpp>
+#include <boost/nowide/utf/convert.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+        //! @cond Doxygen_Suppress
+
+        /// Minimum size of the input per thread for utf::convert_string_parallel
+        /// below which starting a thread costs more than it gains
+        static const std::size_t min_parallel_chunk_size = 64 * 1024;
+
+        /// Split [begin, end) into \a num_chunks ranges of about equal size at code point boundaries.
+        /// Returns the num_chunks + 1 split points, ranges may be empty.
+        template<typename CharIn>
+        std::vector<const CharIn*> split_at_code_points(const CharIn* begin, const CharIn* end, std::size_t num_chunks)
+        {
+            std::vector<const CharIn*> splits(num_chunks + 1, end);
+            splits[0] = begin;
+            const std::size_t size = static_cast<std::size_t>(end - begin);
+            for(std::size_t i = 1; i < num_chunks; i++)
+            {
+                const CharIn* p = (std::max)(splits[i - 1], begin + size / num_chunks * i);
+                while(p != end && !is_code_point_boundary(begin, p))
+                    ++p;
+                splits[i] = p;
+            }
+            return splits;
+        }
+
+        /// Run task(i) for all i in [0, num_tasks) using std::thread and return when all are done
+        struct thread_runner
+        {
+            void operator()(std::size_t num_tasks, const std::function<void(std::size_t)>& task) const
+            {
+                std::vector<std::thread> threads;
+                std::size_t i = 1;
+                try
+                {
+                    threads.reserve(num_tasks - 1);
+                    for(; i < num_tasks; i++)
+                        threads.emplace_back(task, i);
+                } catch(...)
+                {
+                    // Could not start all threads, do the remaining work in this thread
+                    for(; i < num_tasks; i++)
+                        task(i);
+                }
+                task(0);
+                for(std::thread& t : threads)
+                    t.join();
+            }
+        };
+
+        /// Run task(i) for all i in [0, num_tasks) by passing them to a user provided executor
+        /// and return when all are done.
+        /// The tasks refer to local state, so if the executor throws, the rest run here before waiting for the others
+        template<typename Executor>
+        struct executor_runner
+        {
+            Executor& executor;
+
+            void operator()(std::size_t num_tasks, const std::function<void(std::size_t)>& task) const
+            {
+                std::mutex mutex;
+                std::condition_variable done;
+                std::size_t num_running = num_tasks - 1;
+                std::size_t i = 1;
+                try
+                {
+                    for(; i < num_tasks; i++)
+                    {
+                        executor(std::function<void()>([&task, &mutex, &done, &num_running, i]() {
+                            task(i);
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if(--num_running == 0)
+                                done.notify_one();
+                        }));
+                    }
+                } catch(...)
+                {
+                    // Could not post all tasks, do the remaining work in this thread
+                    const std::size_t num_unposted = num_tasks - i;
+                    for(; i < num_tasks; i++)
+                        task(i);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    num_running -= num_unposted;
+                }
+                task(0);
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [&num_running]() { return num_running == 0; });
+            }
+        };
+
+        /// Convert [begin, end) in \a num_chunks independent parts, executed by \a run_tasks:
+        /// First the output length of each part is computed, then each part is converted into its slot of the result
+        template<typename CharOut, typename CharIn, typename Runner>
+        std::basic_string<CharOut>
+        convert_string_parallel(const CharIn* begin, const CharIn* end, std::size_t num_chunks, const Runner& run_tasks)
+        {
+            if(num_chunks < 2)
+                return utf::convert_string<CharOut>(begin, end);
+            const std::vector<const CharIn*> splits = split_at_code_points(begin, end, num_chunks);
+            // Output offset of each chunk, computed from the lengths via a prefix sum
+            std::vector<std::size_t> offsets(num_chunks + 1, 0);
+            run_tasks(num_chunks, [&splits, &offsets](std::size_t i) {
+                offsets[i + 1] = output_length<CharOut>(splits[i], splits[i + 1]);
+            });
+            for(std::size_t i = 0; i < num_chunks; i++)
+                offsets[i + 1] += offsets[i];
+
+            std::basic_string<CharOut> result;
+            const auto convert_chunks = [&splits, &offsets, num_chunks, &run_tasks](CharOut* buffer) {
+                run_tasks(num_chunks, [&splits, &offsets, buffer](std::size_t i) {
+                    const CharIn* in = splits[i];
+                    CharOut* out = buffer + offsets[i];
+                    transcode(in, splits[i + 1], out, buffer + offsets[i + 1]);
+                });
+            };
+#ifdef __cpp_lib_string_resize_and_overwrite
+            result.resize_and_overwrite(offsets.back(), [&convert_chunks](CharOut* buffer, std::size_t buffer_size) {
+                convert_chunks(buffer);
+                return buffer_size;
+            });
+#else
+            result.resize(offsets.back());
+            if(!result.empty())
+                convert_chunks(&result[0]);
+#endif
+            return result;
+        }
+
+        //! @endcond
+    } // namespace detail
+
+    namespace utf {
+
+        /// Convert the UTF sequences in range [begin, end) from \a CharIn to \a CharOut
+        /// using multiple threads and return it as a string.
+        ///
+        /// The input is split into parts at code point boundaries, the output size of each part is computed in parallel
+        /// and then each part is converted in parallel directly into its place in the result.
+        /// The result is the same as the one of convert_string.
+        /// Small inputs are converted by the calling thread only.
+        ///
+        /// \param num_threads Maximum number of threads to use including the calling thread.
+        ///                    Use std::thread::hardware_concurrency() if zero.
+        ///
+        /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+        /// \tparam CharOut Output character type
+        template<typename CharOut, typename CharIn>
+        std::basic_string<CharOut>
+        convert_string_parallel(const CharIn* begin, const CharIn* end, unsigned num_threads = 0)
+        {
+            if(num_threads == 0)
+                num_threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+            const std::size_t max_chunks = static_cast<std::size_t>(end - begin) / detail::min_parallel_chunk_size;
+            const std::size_t num_chunks = (std::min)(static_cast<std::size_t>(num_threads), max_chunks);
+            return detail::convert_string_parallel<CharOut>(begin, end, num_chunks, detail::thread_runner());
+        }
+
+        /// Convert the UTF sequences in range [begin, end) from \a CharIn to \a CharOut
+        /// in \a num_chunks parts using the given \a executor and return it as a string.
+        ///
+        /// Same as the other overload but instead of starting threads, `executor(std::function<void()>)` is called
+        /// with each task to run, e.g. to post it to a thread pool. One part is converted by the calling thread.
+        /// The tasks must either run on other threads or before `executor` returns, the calling thread waits for them.
+        /// If `executor` throws, the task it was called with and all following ones are run by the calling thread.
+        ///
+        /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+        /// \tparam CharOut Output character type
+        template<typename CharOut, typename CharIn, typename Executor>
+        std::basic_string<CharOut>
+        convert_string_parallel(const CharIn* begin, const CharIn* end, Executor&& executor, std::size_t num_chunks)
+        {
+            const detail::executor_runner<typename std::remove_reference<Executor>::type> runner{executor};
+            return detail::convert_string_parallel<CharOut>(begin, end, num_chunks, runner);
+        }
+
+    } // namespace utf
+} // namespace nowide
+} // namespace boost
+
+#endif
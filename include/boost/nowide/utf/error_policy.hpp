@@ -0,0 +1,114 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_UTF_ERROR_POLICY_HPP_INCLUDED
+#define BOOST_NOWIDE_UTF_ERROR_POLICY_HPP_INCLUDED
+
+#include <boost/nowide/utf/utf.hpp>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+namespace boost {
+namespace nowide {
+    namespace utf {
+
+        /// Type of the error policy #replace
+        struct replace_t
+        {};
+        /// Type of the error policy #strict
+        struct strict_t
+        {};
+        /// Type of the error policy #assume_valid
+        struct assume_valid_t
+        {};
+
+        /// Error policy: Replace each invalid sequence with the replacement character,
+        /// see #BOOST_NOWIDE_REPLACEMENT_CHARACTER. This is the default.
+        constexpr replace_t replace{};
+        /// Error policy: Stop at the first invalid sequence and report its position,
+        /// by the returned utf::convert_result or by throwing a utf::conversion_error
+        constexpr strict_t strict{};
+        /// Error policy: The input is known to be valid UTF, e.g. as it was validated before, and is not checked.
+        /// This allows faster conversion but the behavior is undefined for invalid input.
+        constexpr assume_valid_t assume_valid{};
+
+        /// Trait to detect the error policies
+        template<typename T>
+        struct is_error_policy : std::false_type
+        {};
+        template<>
+        struct is_error_policy<replace_t> : std::true_type
+        {};
+        template<>
+        struct is_error_policy<strict_t> : std::true_type
+        {};
+        template<>
+        struct is_error_policy<assume_valid_t> : std::true_type
+        {};
+
+        ///
+        /// \brief Exception thrown when an invalid UTF sequence is converted with the #strict error policy
+        ///
+        class conversion_error : public std::runtime_error
+        {
+        public:
+            conversion_error(std::size_t offset, code_point error) :
+                std::runtime_error(error == incomplete ? "Incomplete UTF sequence" : "Illegal UTF sequence"),
+                offset_(offset), error_(error)
+            {}
+            /// Offset (in code units) of the first invalid sequence in the input
+            std::size_t offset() const
+            {
+                return offset_;
+            }
+            /// Kind of the error: \ref illegal or \ref incomplete
+            code_point error() const
+            {
+                return error_;
+            }
+
+        private:
+            std::size_t offset_;
+            code_point error_;
+        };
+
+    } // namespace utf
+
+    namespace detail {
+        //! @cond Doxygen_Suppress
+        template<typename T>
+        using requires_error_policy = typename std::enable_if<utf::is_error_policy<T>::value>::type;
+
+        /// Decode the next code point from [p, e) checking it unless the input is assumed to be valid
+        template<typename CharIn>
+        BOOST_CXX14_CONSTEXPR utf::code_point decode_code_point(const CharIn*& p, const CharIn* e, utf::replace_t)
+        {
+            return utf::utf_traits<CharIn>::decode(p, e);
+        }
+        template<typename CharIn>
+        BOOST_CXX14_CONSTEXPR utf::code_point decode_code_point(const CharIn*& p, const CharIn* e, utf::strict_t)
+        {
+            return utf::utf_traits<CharIn>::decode(p, e);
+        }
+        template<typename CharIn>
+        BOOST_CXX14_CONSTEXPR utf::code_point
+        decode_code_point(const CharIn*& p, const CharIn* /*e*/, utf::assume_valid_t)
+        {
+            return utf::utf_traits<CharIn>::decode_valid(p);
+        }
+
+        /// True if the conversion stops at an invalid sequence instead of replacing it
+        template<typename Policy>
+        struct stops_at_error : std::is_same<Policy, utf::strict_t>
+        {};
+        //! @endcond
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
+
+#endif
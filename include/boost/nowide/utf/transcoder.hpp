@@ -0,0 +1,181 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_UTF_TRANSCODER_HPP_INCLUDED
+#define BOOST_NOWIDE_UTF_TRANSCODER_HPP_INCLUDED
+
+#include <boost/nowide/detail/transcode.hpp>
+#include <boost/nowide/replacement.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace boost {
+namespace nowide {
+    namespace utf {
+
+        /// Result of transcoder::feed and transcoder::finish
+        struct transcode_result
+        {
+            /// Number of input code units consumed, including those kept as part of an incomplete sequence
+            size_t consumed;
+            /// Number of code units written to the output
+            size_t written;
+            /// Number of invalid sequences replaced by the replacement character
+            size_t replacements;
+        };
+
+        ///
+        /// \brief Converts UTF input from \a CharIn to \a CharOut which arrives in chunks
+        ///
+        /// A sequence split across chunks (up to 3 bytes of UTF-8 or a high surrogate of UTF-16)
+        /// is kept and completed by the next chunk, so the result is the same as converting all input at once,
+        /// e.g. with utf::convert_string.
+        /// The output is written to caller-provided buffers, no memory is allocated.
+        ///
+        /// Any illegal sequences are replaced with the replacement character, see #BOOST_NOWIDE_REPLACEMENT_CHARACTER
+        ///
+        template<typename CharIn, typename CharOut>
+        class transcoder
+        {
+            using input_traits = utf_traits<CharIn>;
+            using output_traits = utf_traits<CharOut>;
+
+        public:
+            transcoder() : pending_size_(0)
+            {}
+
+            /// Convert the chunk [begin, end) to the output buffer of size \a output_size (no trailing NULL is written)
+            ///
+            /// Stops when the next code point doesn't fit into the output.
+            /// In that case call feed again with the unconsumed input, i.e. starting at `begin + result.consumed`.
+            transcode_result feed(const CharIn* begin, const CharIn* end, CharOut* output, size_t output_size)
+            {
+                transcode_result result = {0, 0, 0};
+                const CharIn* in = begin;
+                CharOut* out = output;
+                CharOut* const out_end = output + output_size;
+                // Complete the sequence started in a previous chunk
+                while(pending_size_ != 0)
+                {
+                    CharIn tmp[input_traits::max_width];
+                    const size_t max_new = static_cast<size_t>(input_traits::max_width) - pending_size_;
+                    const size_t num_new = (std::min)(static_cast<size_t>(end - in), max_new);
+                    std::copy(pending_, pending_ + pending_size_, tmp);
+                    std::copy(in, in + num_new, tmp + pending_size_);
+                    const CharIn* p = tmp;
+                    const CharIn* const tmp_end = tmp + pending_size_ + num_new;
+                    code_point c = input_traits::decode(p, tmp_end);
+                    if(c == incomplete)
+                    {
+                        // Still incomplete as the chunk is too short, keep all of it
+                        assert(in + num_new == end);
+                        std::copy(in, end, pending_ + pending_size_);
+                        pending_size_ += num_new;
+                        in = end;
+                        break;
+                    }
+                    const bool is_valid = c != illegal;
+                    if(!is_valid)
+                        c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
+                    if(out_end - out < output_traits::width(c))
+                        break;
+                    out = output_traits::encode(c, out);
+                    if(!is_valid)
+                        ++result.replacements;
+                    const size_t used = static_cast<size_t>(p - tmp);
+                    if(used >= pending_size_)
+                    {
+                        in += used - pending_size_;
+                        pending_size_ = 0;
+                    } else
+                    {
+                        // Only a part of the pending units formed a sequence, decode the rest again
+                        std::copy(pending_ + used, pending_ + pending_size_, pending_);
+                        pending_size_ -= used;
+                    }
+                }
+                if(pending_size_ == 0)
+                    convert(in, end, out, out_end, result.replacements);
+                result.consumed = static_cast<size_t>(in - begin);
+                result.written = static_cast<size_t>(out - output);
+                return result;
+            }
+
+            /// Signal the end of the input, i.e. write a replacement character for an incomplete sequence
+            /// at the end of the last chunk if there is one.
+            /// Afterwards the transcoder can be used for new input.
+            ///
+            /// If the output is too small nothing is written and finish needs to be called again.
+            transcode_result finish(CharOut* output, size_t output_size)
+            {
+                transcode_result result = {0, 0, 0};
+                if(pending_size_ != 0 && output_size >= static_cast<size_t>(output_traits::width(
+                                                          BOOST_NOWIDE_REPLACEMENT_CHARACTER)))
+                {
+                    result.written = static_cast<size_t>(
+                      output_traits::encode(BOOST_NOWIDE_REPLACEMENT_CHARACTER, output) - output);
+                    result.replacements = 1;
+                    pending_size_ = 0;
+                }
+                return result;
+            }
+
+            /// Return the number of input code units kept from the last chunk as part of an incomplete sequence
+            size_t pending() const
+            {
+                return pending_size_;
+            }
+
+            /// Discard any pending input
+            void reset()
+            {
+                pending_size_ = 0;
+            }
+
+        private:
+            /// Same as detail::transcode, but keeps an incomplete sequence at the end of the input as pending
+            void convert(const CharIn*& in, const CharIn* end, CharOut*& out, CharOut* out_end, size_t& replacements)
+            {
+                while(in != end)
+                {
+                    detail::bulk_transcoder<CharOut, CharIn>::run(in, end, out, out_end);
+                    detail::copy_ascii(in, end, out, out_end);
+                    if(in == end)
+                        break;
+                    const CharIn* const cur = in;
+                    code_point c = input_traits::decode(in, end);
+                    if(c == incomplete)
+                    {
+                        std::copy(cur, end, pending_);
+                        pending_size_ = static_cast<size_t>(end - cur);
+                        break;
+                    }
+                    const bool is_valid = c != illegal;
+                    if(!is_valid)
+                        c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
+                    if(out_end - out < output_traits::width(c))
+                    {
+                        in = cur;
+                        break;
+                    }
+                    out = output_traits::encode(c, out);
+                    if(!is_valid)
+                        ++replacements;
+                }
+            }
+
+            CharIn pending_[input_traits::max_width];
+            size_t pending_size_;
+        };
+
+    } // namespace utf
+} // namespace nowide
+} // namespace boost
+
+#endif
@@ -10,6 +10,7 @@
 #define BOOST_NOWIDE_UTF_HPP_INCLUDED
 
 #include <boost/nowide/config.hpp>
+#include <boost/nowide/detail/utf8_dfa.hpp>
 #include <cstdint>
 
 namespace boost {
@@ -17,7 +18,9 @@ namespace nowide {
     ///
     /// \brief Namespace that holds basic operations on UTF encoded sequences
     ///
-    /// All functions defined in this namespace do not require linking with Boost.Nowide library.
+    /// The functions defined in this namespace do not require linking with Boost.Nowide library
+    /// unless BOOST_NOWIDE_RUNTIME_DISPATCH is defined (the default when using the CMake target or B2):
+    /// The conversions then choose their vectorized kernels via the compiled library.
     /// Extracted from Boost.Locale
     ///
     namespace utf {
@@ -40,7 +43,7 @@ namespace nowide {
         ///
         /// \brief the function checks if \a v is a valid code point
         ///
-        inline bool is_valid_codepoint(code_point v)
+        BOOST_CXX14_CONSTEXPR inline bool is_valid_codepoint(code_point v)
         {
             if(v > 0x10FFFF)
                 return false;
@@ -139,7 +142,7 @@ namespace nowide {
         {
             using char_type = CharType;
 
-            static int trail_length(char_type ci)
+            static BOOST_CXX14_CONSTEXPR int trail_length(char_type ci)
             {
                 unsigned char c = ci;
                 if(c < 128)
@@ -157,7 +160,7 @@ namespace nowide {
 
             static const int max_width = 4;
 
-            static int width(code_point value)
+            static BOOST_CXX14_CONSTEXPR int width(code_point value)
             {
                 if(value <= 0x7F)
                 {
@@ -174,20 +177,23 @@ namespace nowide {
                 }
             }
 
-            static bool is_trail(char_type ci)
+            static BOOST_CXX14_CONSTEXPR bool is_trail(char_type ci)
             {
                 unsigned char c = ci;
                 return (c & 0xC0) == 0x80;
             }
 
-            static bool is_lead(char_type ci)
+            static BOOST_CXX14_CONSTEXPR bool is_lead(char_type ci)
             {
                 return !is_trail(ci);
             }
 
             template<typename Iterator>
-            static code_point decode(Iterator& p, Iterator e)
+            static BOOST_CXX14_CONSTEXPR code_point decode(Iterator& p, Iterator e)
             {
+#ifdef BOOST_NOWIDE_USE_UTF8_DFA
+                return decode_dfa(p, e);
+#else
                 if(BOOST_UNLIKELY(p == e))
                     return incomplete;
 
@@ -207,7 +213,7 @@ namespace nowide {
                 code_point c = lead & ((1 << (6 - trail_size)) - 1);
 
                 // Read the rest
-                unsigned char tmp;
+                unsigned char tmp = 0;
                 switch(trail_size)
                 {
                 case 3:
@@ -245,16 +251,50 @@ namespace nowide {
                 }
 
                 return c;
+#endif
+            }
+
+            /// Same as decode, but driven by a state transition table instead of branching on the lead byte
+            /// and the number of trail bytes, which avoids mispredictions on text mixing sequences of different length.
+            /// Used by decode (and hence all conversions) if BOOST_NOWIDE_USE_UTF8_DFA is defined.
+            template<typename Iterator>
+            static BOOST_CXX14_CONSTEXPR code_point decode_dfa(Iterator& p, Iterator e)
+            {
+                using dfa = detail::utf8_dfa<>;
+                if(BOOST_UNLIKELY(p == e))
+                    return incomplete;
+
+                unsigned char byte = *p++;
+                if(byte < 0x80)
+                    return byte;
+                const unsigned char type = dfa::byte_class[byte];
+                code_point c = byte & dfa::lead_mask[type];
+                unsigned state = dfa::transitions[type];
+                int trail_size = 0;
+                while(state >= dfa::first_pending)
+                {
+                    if(BOOST_UNLIKELY(p == e))
+                        return incomplete;
+                    byte = *p++;
+                    ++trail_size;
+                    state = dfa::transitions[state + dfa::byte_class[byte]];
+                    c = (c << 6) | (byte & 0x3Fu);
+                }
+                if(BOOST_LIKELY(state == dfa::accept))
+                    return c;
+                if(state == dfa::rollback)
+                    p -= trail_size;
+                return illegal;
             }
 
             template<typename Iterator>
-            static code_point decode_valid(Iterator& p)
+            static BOOST_CXX14_CONSTEXPR code_point decode_valid(Iterator& p)
             {
                 unsigned char lead = *p++;
                 if(lead < 192)
                     return lead;
 
-                int trail_size;
+                int trail_size = 0;
 
                 if(lead < 224)
                     trail_size = 1;
@@ -276,7 +316,7 @@ namespace nowide {
             }
 
             template<typename Iterator>
-            static Iterator encode(code_point value, Iterator out)
+            static BOOST_CXX14_CONSTEXPR Iterator encode(code_point value, Iterator out)
             {
                 if(value <= 0x7F)
                 {
@@ -307,26 +347,26 @@ namespace nowide {
             using char_type = CharType;
 
             // See RFC 2781
-            static bool is_single_codepoint(uint16_t x)
+            static BOOST_CXX14_CONSTEXPR bool is_single_codepoint(uint16_t x)
             {
                 // Ranges [U+0000, 0+D7FF], [U+E000, U+FFFF] are numerically equal in UTF-16
                 return x <= 0xD7FF || x >= 0xE000;
             }
-            static bool is_first_surrogate(uint16_t x)
+            static BOOST_CXX14_CONSTEXPR bool is_first_surrogate(uint16_t x)
             {
                 // Range [U+D800, 0+DBFF]: High surrogate
                 return 0xD800 <= x && x <= 0xDBFF;
             }
-            static bool is_second_surrogate(uint16_t x)
+            static BOOST_CXX14_CONSTEXPR bool is_second_surrogate(uint16_t x)
             {
                 // Range [U+DC00, 0+DFFF]: Low surrogate
                 return 0xDC00 <= x && x <= 0xDFFF;
             }
-            static code_point combine_surrogate(uint16_t w1, uint16_t w2)
+            static BOOST_CXX14_CONSTEXPR code_point combine_surrogate(uint16_t w1, uint16_t w2)
             {
                 return ((code_point(w1 & 0x3FF) << 10) | (w2 & 0x3FF)) + 0x10000;
             }
-            static int trail_length(char_type c)
+            static BOOST_CXX14_CONSTEXPR int trail_length(char_type c)
             {
                 if(is_first_surrogate(c))
                     return 1;
@@ -335,18 +375,18 @@ namespace nowide {
                 return 0;
             }
             /// Return true if c is trail code unit, always false for UTF-32
-            static bool is_trail(char_type c)
+            static BOOST_CXX14_CONSTEXPR bool is_trail(char_type c)
             {
                 return is_second_surrogate(c);
             }
             /// Return true if c is lead code unit, always true of UTF-32
-            static bool is_lead(char_type c)
+            static BOOST_CXX14_CONSTEXPR bool is_lead(char_type c)
             {
                 return !is_second_surrogate(c);
             }
 
             template<typename It>
-            static code_point decode(It& current, It last)
+            static BOOST_CXX14_CONSTEXPR code_point decode(It& current, It last)
             {
                 if(BOOST_UNLIKELY(current == last))
                     return incomplete;
@@ -366,7 +406,7 @@ namespace nowide {
                 return combine_surrogate(w1, w2);
             }
             template<typename It>
-            static code_point decode_valid(It& current)
+            static BOOST_CXX14_CONSTEXPR code_point decode_valid(It& current)
             {
                 uint16_t w1 = *current++;
                 if(BOOST_LIKELY(is_single_codepoint(w1)))
@@ -378,12 +418,12 @@ namespace nowide {
             }
 
             static const int max_width = 2;
-            static int width(code_point u)
+            static BOOST_CXX14_CONSTEXPR int width(code_point u)
             {
                 return u >= 0x10000 ? 2 : 1;
             }
             template<typename It>
-            static It encode(code_point u, It out)
+            static BOOST_CXX14_CONSTEXPR It encode(code_point u, It out)
             {
                 if(BOOST_LIKELY(u <= 0xFFFF))
                 {
@@ -402,29 +442,29 @@ namespace nowide {
         struct utf_traits<CharType, 4>
         {
             using char_type = CharType;
-            static int trail_length(char_type c)
+            static BOOST_CXX14_CONSTEXPR int trail_length(char_type c)
             {
                 if(is_valid_codepoint(c))
                     return 0;
                 return -1;
             }
-            static bool is_trail(char_type /*c*/)
+            static BOOST_CXX14_CONSTEXPR bool is_trail(char_type /*c*/)
             {
                 return false;
             }
-            static bool is_lead(char_type /*c*/)
+            static BOOST_CXX14_CONSTEXPR bool is_lead(char_type /*c*/)
             {
                 return true;
             }
 
             template<typename It>
-            static code_point decode_valid(It& current)
+            static BOOST_CXX14_CONSTEXPR code_point decode_valid(It& current)
             {
                 return *current++;
             }
 
             template<typename It>
-            static code_point decode(It& current, It last)
+            static BOOST_CXX14_CONSTEXPR code_point decode(It& current, It last)
             {
                 if(BOOST_UNLIKELY(current == last))
                     return incomplete;
@@ -434,12 +474,12 @@ namespace nowide {
                 return c;
             }
             static const int max_width = 1;
-            static int width(code_point /*u*/)
+            static BOOST_CXX14_CONSTEXPR int width(code_point /*u*/)
             {
                 return 1;
             }
             template<typename It>
-            static It encode(code_point u, It out)
+            static BOOST_CXX14_CONSTEXPR It encode(code_point u, It out)
             {
                 *out++ = static_cast<char_type>(u);
                 return out;
@@ -0,0 +1,216 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef BOOST_NOWIDE_UTF_VALIDATE_HPP_INCLUDED
+#define BOOST_NOWIDE_UTF_VALIDATE_HPP_INCLUDED
+
+#include <boost/nowide/detail/kernels_count.hpp>
+#include <boost/nowide/detail/kernels_validate.hpp>
+#include <boost/nowide/replacement.hpp>
+#include <boost/nowide/utf/utf.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+namespace boost {
+namespace nowide {
+    namespace utf {
+
+        /// Result of validating a range of UTF code units
+        struct validation_result
+        {
+            /// Offset (in code units) of the first invalid sequence or the size of the range if it is valid
+            std::size_t offset;
+            /// Kind of the error: \ref illegal or \ref incomplete if an invalid sequence was found, 0 otherwise
+            code_point error;
+
+            /// Return true if the range is valid
+            bool valid() const
+            {
+                return error == 0;
+            }
+        };
+
+        /// Return the start of the first invalid UTF sequence in the range [begin, end) or \a end if it is valid.
+        ///
+        /// A sequence is invalid if utf_traits<CharIn>::decode returns \ref illegal or \ref incomplete for it.
+        /// UTF-8 input is validated in blocks using SIMD instructions where available.
+        /// If \a error is not NULL it is set to the kind of the error or 0 if the range is valid.
+        template<typename CharIn>
+        const CharIn* find_first_invalid(const CharIn* begin, const CharIn* end, code_point* error = nullptr)
+        {
+            const CharIn* p = detail::bulk_validator<CharIn>::run(begin, end);
+            while(p != end)
+            {
+                const CharIn* const cur = p;
+                const code_point c = utf_traits<CharIn>::decode(p, end);
+                if(c == illegal || c == incomplete)
+                {
+                    if(error)
+                        *error = c;
+                    return cur;
+                }
+            }
+            if(error)
+                *error = 0;
+            return end;
+        }
+
+        /// Check if the range [begin, end) consists of valid UTF sequences only
+        /// and return the offset and kind of the first invalid sequence, see find_first_invalid
+        template<typename CharIn>
+        validation_result validate(const CharIn* begin, const CharIn* end)
+        {
+            validation_result result;
+            result.offset = static_cast<std::size_t>(find_first_invalid(begin, end, &result.error) - begin);
+            return result;
+        }
+
+        /// Return true if all code units in the range [begin, end) are ASCII, i.e. below 0x80.
+        ///
+        /// The input is checked in blocks of up to 64 bytes using SIMD instructions where available.
+        template<typename CharIn>
+        bool is_ascii(const CharIn* begin, const CharIn* end)
+        {
+            for(const CharIn* p = detail::ascii_prefix(begin, end); p != end; ++p)
+            {
+                if(!detail::is_ascii_unit(*p))
+                    return false;
+            }
+            return true;
+        }
+
+        /// Return the number of code points in the range [begin, end) of valid UTF without decoding them.
+        ///
+        /// UTF-8 and UTF-16 input is counted in blocks using SIMD instructions where available.
+        /// Only the code units which never start a code point are skipped, i.e. UTF-8 continuation bytes
+        /// and UTF-16 low surrogates, so for invalid input the result may differ from the number of code points
+        /// after replacing the invalid sequences, which is `output_length<char32_t>(begin, end)`.
+        template<typename CharIn>
+        std::size_t count_codepoints(const CharIn* begin, const CharIn* end)
+        {
+            return detail::count_code_points(begin, end, detail::code_unit_size<CharIn>());
+        }
+
+    } // namespace utf
+
+    namespace detail {
+        //! @cond Doxygen_Suppress
+
+        /// Return the maximum growth (in code units) of any prefix of [p, end) when replacing the invalid sequences
+        /// by the replacement character and add their number to \a replacements
+        template<typename Char>
+        std::size_t max_sanitize_growth(const Char* p, const Char* end, std::size_t& replacements)
+        {
+            const std::ptrdiff_t replacement_width = utf::utf_traits<Char>::width(BOOST_NOWIDE_REPLACEMENT_CHARACTER);
+            std::ptrdiff_t growth = 0;
+            std::ptrdiff_t max_growth = 0;
+            while((p = utf::find_first_invalid(p, end)) != end)
+            {
+                const Char* const cur = p;
+                utf::utf_traits<Char>::decode(p, end);
+                growth += replacement_width - (p - cur);
+                max_growth = (std::max)(max_growth, growth);
+                ++replacements;
+            }
+            return static_cast<std::size_t>(max_growth);
+        }
+
+        /// Write [p, end) with the invalid sequences replaced to \a out and return the end of the output.
+        /// \a out may point into the input as long as the output never overtakes it,
+        /// i.e. \a out must be at least max_sanitize_growth(p, end) code units before \a p
+        template<typename Char>
+        Char* sanitize_to(const Char* p, const Char* end, Char* out)
+        {
+            while(p != end)
+            {
+                const Char* const invalid = utf::find_first_invalid(p, end);
+                out = std::copy(p, invalid, out);
+                if(invalid == end)
+                    break;
+                p = invalid;
+                utf::utf_traits<Char>::decode(p, end);
+                out = utf::utf_traits<Char>::encode(BOOST_NOWIDE_REPLACEMENT_CHARACTER, out);
+            }
+            return out;
+        }
+
+        /// Replace the invalid sequences of the input of \a size code units at \a buffer in place,
+        /// where the first one is at \a offset and the buffer has room for \a max_growth more code units.
+        /// Return the end of the output
+        template<typename Char>
+        Char* sanitize_in_place(Char* buffer, std::size_t offset, std::size_t size, std::size_t max_growth)
+        {
+            // Move the rest of the input back so the output written from the first invalid sequence on
+            // never overtakes it
+            if(max_growth != 0)
+                std::copy_backward(buffer + offset, buffer + size, buffer + size + max_growth);
+            return sanitize_to(buffer + offset + max_growth, buffer + size + max_growth, buffer + offset);
+        }
+
+        //! @endcond
+    } // namespace detail
+
+    namespace utf {
+
+        /// Replace the invalid UTF sequences in the string \a s by the replacement character in place,
+        /// see #BOOST_NOWIDE_REPLACEMENT_CHARACTER, with the same result as `convert_string<Char>` would have.
+        ///
+        /// The string is validated first (see find_first_invalid), if it is valid nothing is written.
+        /// Otherwise the part from the first invalid sequence on is processed in up to 3 more passes:
+        /// One counting the replacements and the required growth, which is positive if the replacements are longer
+        /// than the sequences they replace (e.g. single bytes of UTF-8 replaced by 3 bytes),
+        /// in that case one moving the part back by that growth, and one writing the result in front of it.
+        /// The storage of \a s is reused and only grows by that amount.
+        /// \return The number of invalid sequences replaced
+        template<typename Char>
+        std::size_t sanitize(std::basic_string<Char>& s)
+        {
+            const Char* const begin = s.data();
+            const Char* const end = begin + s.size();
+            const Char* const first_invalid = find_first_invalid(begin, end);
+            if(first_invalid == end)
+                return 0;
+            std::size_t replacements = 0;
+            const std::size_t max_growth = detail::max_sanitize_growth(first_invalid, end, replacements);
+            const std::size_t offset = static_cast<std::size_t>(first_invalid - begin);
+            const std::size_t size = s.size();
+            s.resize(size + max_growth);
+            Char* const buffer = &s[0];
+            s.resize(static_cast<std::size_t>(detail::sanitize_in_place(buffer, offset, size, max_growth) - buffer));
+            return replacements;
+        }
+
+        /// Replace the invalid UTF sequences of the text of \a size code units in \a buffer (of size \a buffer_size)
+        /// by the replacement character in place, see sanitize(std::basic_string<Char>&).
+        ///
+        /// \return The end of the sanitized text or NULL if the buffer is too small for the result
+        /// or the intermediate growth of it, in which case the buffer is unchanged.
+        /// NULL is also returned if \a size exceeds \a buffer_size.
+        template<typename Char>
+        Char* sanitize(Char* buffer, std::size_t size, std::size_t buffer_size)
+        {
+            if(size > buffer_size)
+                return nullptr;
+            Char* const end = buffer + size;
+            const Char* const first_invalid = find_first_invalid<Char>(buffer, end);
+            if(first_invalid == end)
+                return end;
+            std::size_t replacements = 0;
+            const std::size_t max_growth = detail::max_sanitize_growth(first_invalid, end, replacements);
+            if(buffer_size - size < max_growth)
+                return nullptr;
+            const std::size_t offset = static_cast<std::size_t>(first_invalid - buffer);
+            return detail::sanitize_in_place(buffer, offset, size, max_growth);
+        }
+
+    } // namespace utf
+} // namespace nowide
+} // namespace boost
+
+#endif
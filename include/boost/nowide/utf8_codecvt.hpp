@@ -9,6 +9,7 @@
 #ifndef BOOST_NOWIDE_UTF8_CODECVT_HPP_INCLUDED
 #define BOOST_NOWIDE_UTF8_CODECVT_HPP_INCLUDED
 
+#include <boost/nowide/detail/transcode.hpp>
 #include <boost/nowide/replacement.hpp>
 #include <boost/nowide/utf/utf.hpp>
 #include <cstdint>
@@ -143,6 +144,11 @@ namespace nowide {
             }
             while(to < to_end && from < from_end)
             {
+                detail::bulk_transcoder<uchar, char>::run(from, from_end, to, to_end);
+                detail::copy_ascii(from, from_end, to, to_end);
+                if(to == to_end || from == from_end)
+                    break;
+
                 const char* from_saved = from;
 
                 uint32_t ch = utf::utf_traits<char>::decode(from, from_end);
@@ -192,6 +198,11 @@ namespace nowide {
             // (i.e. state = stateT()) according to standard.
             // We use it to store the first observed surrogate pair, or 0 if there is none yet
             std::uint16_t state = detail::read_state(std_state);
+            if(state == 0)
+            {
+                detail::bulk_transcoder<char, uchar>::run(from, from_end, to, to_end);
+                detail::copy_ascii(from, from_end, to, to_end);
+            }
             for(; to < to_end && from < from_end; ++from)
             {
                 std::uint32_t ch = 0;
@@ -311,6 +322,11 @@ namespace nowide {
 
             while(to < to_end && from < from_end)
             {
+                detail::bulk_transcoder<uchar, char>::run(from, from_end, to, to_end);
+                detail::copy_ascii(from, from_end, to, to_end);
+                if(to == to_end || from == from_end)
+                    break;
+
                 const char* from_saved = from;
 
                 uint32_t ch = utf::utf_traits<char>::decode(from, from_end);
@@ -342,6 +358,8 @@ namespace nowide {
                                          char*& to_next) const override
         {
             std::codecvt_base::result r = std::codecvt_base::ok;
+            detail::bulk_transcoder<char, uchar>::run(from, from_end, to, to_end);
+            detail::copy_ascii(from, from_end, to, to_end);
             while(to < to_end && from < from_end)
             {
                 std::uint32_t ch = 0;
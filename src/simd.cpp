@@ -0,0 +1,135 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#define BOOST_NOWIDE_SOURCE
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <boost/nowide/detail/simd.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BOOST_NOWIDE_X86 1
+#if defined(__GNUC__) || defined(__clang__)
+#include <cpuid.h>
+#endif
+#endif
+
+namespace boost {
+namespace nowide {
+    namespace detail {
+#ifdef BOOST_NOWIDE_X86
+        namespace {
+            struct cpuid_result
+            {
+                unsigned eax, ebx, ecx, edx;
+            };
+
+            cpuid_result cpuid(const unsigned leaf, const unsigned subleaf = 0)
+            {
+                cpuid_result r = {0, 0, 0, 0};
+#ifdef _MSC_VER
+                int regs[4];
+                __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+                r.eax = static_cast<unsigned>(regs[0]);
+                r.ebx = static_cast<unsigned>(regs[1]);
+                r.ecx = static_cast<unsigned>(regs[2]);
+                r.edx = static_cast<unsigned>(regs[3]);
+#else
+                if(leaf <= __get_cpuid_max(0, nullptr))
+                    __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+                return r;
+            }
+
+            /// Return the register state enabled by the OS (XCR0)
+            unsigned long long xgetbv()
+            {
+#ifdef _MSC_VER
+                return _xgetbv(0);
+#else
+                unsigned eax, edx;
+                __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+                return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+            }
+
+            simd_isa detect_simd_isa()
+            {
+                const cpuid_result leaf1 = cpuid(1);
+                if(!(leaf1.edx & (1u << 26)))
+                    return simd_isa::scalar;
+                if(!(leaf1.ecx & (1u << 19)))
+                    return simd_isa::sse2;
+                // AVX requires the OS to save the YMM registers
+                const bool osxsave = (leaf1.ecx & (1u << 27)) != 0;
+                const unsigned long long xcr0 = osxsave ? xgetbv() : 0;
+                if((xcr0 & 0x6) != 0x6)
+                    return simd_isa::sse41;
+                const cpuid_result leaf7 = cpuid(7);
+                if(!(leaf7.ebx & (1u << 5)))
+                    return simd_isa::sse41;
+                // AVX-512 additionally requires the opmask and ZMM registers to be saved
+                const bool avx512bw = (leaf7.ebx & (1u << 16)) && (leaf7.ebx & (1u << 30));
+                if(!avx512bw || (xcr0 & 0xE6) != 0xE6)
+                    return simd_isa::avx2;
+                return simd_isa::avx512bw;
+            }
+        } // namespace
+#else
+        namespace {
+            simd_isa detect_simd_isa()
+            {
+                return simd_isa::scalar;
+            }
+        } // namespace
+#endif
+
+        namespace {
+            /// Apply the limit from the environment variable BOOST_NOWIDE_FORCE_ISA, if set.
+            /// Unknown values are reported on stderr and ignored as the library must not terminate the host process
+            simd_isa limit_simd_isa(const simd_isa detected)
+            {
+                const char* forced = std::getenv("BOOST_NOWIDE_FORCE_ISA");
+                if(!forced || !*forced)
+                    return detected;
+                simd_isa limit;
+                if(std::strcmp(forced, "scalar") == 0)
+                    limit = simd_isa::scalar;
+                else if(std::strcmp(forced, "sse2") == 0)
+                    limit = simd_isa::sse2;
+                else if(std::strcmp(forced, "sse4.1") == 0 || std::strcmp(forced, "sse41") == 0)
+                    limit = simd_isa::sse41;
+                else if(std::strcmp(forced, "avx2") == 0)
+                    limit = simd_isa::avx2;
+                else if(std::strcmp(forced, "avx512bw") == 0)
+                    limit = simd_isa::avx512bw;
+                else
+                {
+                    std::fprintf(stderr,
+                                 "Boost.Nowide: Ignoring invalid value '%s' of BOOST_NOWIDE_FORCE_ISA, "
+                                 "expected one of scalar, sse2, sse4.1, avx2, avx512bw\n",
+                                 forced);
+                    return detected;
+                }
+                return (limit < detected) ? limit : detected;
+            }
+        } // namespace
+
+        simd_isa runtime_simd_isa()
+        {
+            static const simd_isa isa = limit_simd_isa(detect_simd_isa());
+            return isa;
+        }
+    } // namespace detail
+} // namespace nowide
+} // namespace boost
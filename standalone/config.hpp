@@ -76,4 +76,29 @@
 #endif
 #endif
 
+#if(defined(__cpp_constexpr) && __cpp_constexpr >= 201304) \
+  || (defined(_MSC_VER) && _MSC_VER >= 1910 && defined(_MSVC_LANG) && _MSVC_LANG >= 201402)
+#define BOOST_CXX14_CONSTEXPR constexpr
+#else
+#define BOOST_CXX14_CONSTEXPR
+#define BOOST_NO_CXX14_CONSTEXPR
+#endif
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define BOOST_NOWIDE_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(BOOST_NOWIDE_IS_CONSTANT_EVALUATED) \
+  && ((defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define BOOST_NOWIDE_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+#if defined(BOOST_NOWIDE_IS_CONSTANT_EVALUATED) && !defined(BOOST_NO_CXX14_CONSTEXPR)
+#define BOOST_NOWIDE_CONSTEXPR_CONVERT constexpr
+#else
+#define BOOST_NOWIDE_CONSTEXPR_CONVERT
+#define BOOST_NOWIDE_NO_CONSTEXPR_CONVERT
+#endif
+
 #endif
@@ -0,0 +1,365 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Compares the throughput of utf::convert_string to converting one code point at a time via utf_traits
+// and the branching UTF-8 decoder to the table driven one (utf_traits<char>::decode_dfa).
+// For NULL terminated input searching the terminator during the conversion is compared to a separate utf::strlen
+// and utf::strlen to a loop over the code units.
+// Converting with the utf::assume_valid error policy is compared to the default (utf::replace).
+// utf::count_codepoints and utf::output_length are compared to decoding each code point.
+// utf::convert_batch is compared to calling utf::convert_string for each of many short strings.
+// Latin-1 input (utf::latin1_char) is converted from the corpora representable in it.
+// With BOOST_NOWIDE_RUNTIME_DISPATCH set BOOST_NOWIDE_FORCE_ISA=scalar to measure the portable (SWAR) kernels.
+
+#define BOOST_NOWIDE_TEST_NO_MAIN
+
+#include <boost/nowide/utf/codepage.hpp>
+#include <boost/nowide/utf/convert.hpp>
+#include <boost/nowide/utf/convert_batch.hpp>
+#include <boost/nowide/utf/validate.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+#include "test_sets.hpp"
+
+namespace utf = boost::nowide::utf;
+
+struct corpus
+{
+    const char* name;
+    std::string utf8;
+};
+
+/// Create about `size` bytes of UTF-8 text of words with letters from [first, last]
+/// separated by spaces and with every `ascii_ratio`th letter being ASCII
+std::string create_text(utf::code_point first, utf::code_point last, unsigned ascii_ratio, size_t size)
+{
+    std::minstd_rand rng(42);
+    std::uniform_int_distribution<utf::code_point> letters(first, last);
+    std::uniform_int_distribution<utf::code_point> ascii_letters('a', 'z');
+    std::string result;
+    char buf[4];
+    for(unsigned i = 1; result.size() < size; i++)
+    {
+        const utf::code_point c = (i % 8 == 0)                           ? ' '
+                                  : (ascii_ratio && i % ascii_ratio == 0) ? ascii_letters(rng)
+                                                                          : letters(rng);
+        result.append(buf, utf::utf_traits<char>::encode(c, buf));
+    }
+    return result;
+}
+
+/// Create about `size` bytes of UTF-8 text of words each using letters of a random script
+std::string create_mixed_text(size_t size)
+{
+    const utf::code_point ranges[][2] = {
+      {'a', 'z'}, {0xC0, 0xFF}, {0x410, 0x44F}, {0x4E00, 0x9FFF}, {0x1F600, 0x1F64F}};
+    std::minstd_rand rng(42);
+    std::string result;
+    char buf[4];
+    while(result.size() < size)
+    {
+        const auto& range = ranges[rng() % 5];
+        std::uniform_int_distribution<utf::code_point> letters(range[0], range[1]);
+        for(unsigned i = rng() % 7; i > 0; i--)
+            result.append(buf, utf::utf_traits<char>::encode(letters(rng), buf));
+        result += ' ';
+    }
+    return result;
+}
+
+std::vector<corpus> create_corpora(size_t size)
+{
+    std::vector<corpus> result;
+    result.push_back({"ASCII", create_text('a', 'z', 0, size)});
+    result.push_back({"Latin", create_text(0xC0, 0xFF, 2, size)});
+    result.push_back({"Cyrillic", create_text(0x410, 0x44F, 0, size)});
+    result.push_back({"CJK", create_text(0x4E00, 0x9FFF, 0, size)});
+    result.push_back({"Emoji", create_text(0x1F600, 0x1F64F, 0, size)});
+    result.push_back({"Mixed", create_mixed_text(size)});
+    return result;
+}
+
+/// Return the throughput of `convert` in MB/s of `input_size` bytes of input, best of several runs
+template<typename Converter>
+double measure(const Converter& convert, size_t input_size)
+{
+    namespace chrono = std::chrono;
+    using clock = chrono::high_resolution_clock;
+    using milliseconds = chrono::duration<double, std::milli>;
+    const int repeats = 20;
+    double best = 0;
+    size_t dummy = 0;
+    for(int i = 0; i < repeats; i++)
+    {
+        const clock::time_point start = clock::now();
+        dummy += convert();
+        const milliseconds duration = chrono::duration_cast<milliseconds>(clock::now() - start);
+        const double speed = input_size / duration.count() / 1024; // MB/s
+        if(speed > best)
+            best = speed;
+    }
+    TEST(dummy != 0);
+    return best;
+}
+
+template<typename CharOut, typename CharIn>
+void benchmark(const char* name, const std::basic_string<CharIn>& s)
+{
+    const size_t input_size = s.size() * sizeof(CharIn);
+    const double per_code_point = measure([&s]() { return convert_reference<CharOut>(s).size(); }, input_size);
+    const double bulk = measure(
+      [&s]() { return utf::convert_string<CharOut>(s.data(), s.data() + s.size()).size(); }, input_size);
+    std::cout << std::setw(10) << name << std::fixed << std::setprecision(1) << std::setw(12) << per_code_point
+              << " MB/s" << std::setw(12) << bulk << " MB/s" << std::setw(8) << bulk / per_code_point << "x"
+              << std::endl;
+}
+
+/// Sum of all code points decoded from s via `decode`, invalid ones count as 0
+template<typename Decoder>
+size_t decode_all(const std::string& s, Decoder decode)
+{
+    size_t sum = 0;
+    const char* const end = s.data() + s.size();
+    for(const char* p = s.data(); p != end;)
+    {
+        const utf::code_point c = decode(p, end);
+        if(c != utf::illegal && c != utf::incomplete)
+            sum += c;
+    }
+    return sum;
+}
+
+/// Compare the branching UTF-8 decoder of utf_traits to the table driven one
+void benchmark_decoders(const std::vector<corpus>& corpora)
+{
+    using utf8_traits = utf::utf_traits<char>;
+    std::cout << "================== UTF-8 decoding ==================" << std::endl;
+    std::cout << std::setw(10) << "Corpus" << std::setw(17) << "branches" << std::setw(17) << "DFA" << std::setw(9)
+              << "speedup" << std::endl;
+    for(const corpus& c : corpora)
+    {
+        const std::string& s = c.utf8;
+        const double branches = measure(
+          [&s]() { return decode_all(s, [](const char*& p, const char* e) { return utf8_traits::decode(p, e); }); },
+          s.size());
+        const double dfa = measure(
+          [&s]() { return decode_all(s, [](const char*& p, const char* e) { return utf8_traits::decode_dfa(p, e); }); },
+          s.size());
+        std::cout << std::setw(10) << c.name << std::fixed << std::setprecision(1) << std::setw(12) << branches
+                  << " MB/s" << std::setw(12) << dfa << " MB/s" << std::setw(8) << dfa / branches << "x" << std::endl;
+    }
+}
+
+/// Compare converting NULL terminated strings after determining their length to searching the terminator on the fly
+template<typename CharOut, typename CharIn>
+void benchmark_terminated(const char* name, const std::basic_string<CharIn>& s)
+{
+    const size_t input_size = s.size() * sizeof(CharIn);
+    const CharIn* const str = s.c_str();
+    const double separate = measure(
+      [str]() { return utf::convert_string<CharOut>(str, str + utf::strlen(str)).size(); }, input_size);
+    const double fused = measure([str]() { return utf::convert_string<CharOut>(str).size(); }, input_size);
+    std::cout << std::setw(10) << name << std::fixed << std::setprecision(1) << std::setw(12) << separate << " MB/s"
+              << std::setw(12) << fused << " MB/s" << std::setw(8) << fused / separate << "x" << std::endl;
+}
+
+/// Compare utf::strlen to counting one code unit at a time
+template<typename Char>
+void benchmark_strlen(const char* name, const std::basic_string<Char>& s)
+{
+    const size_t input_size = s.size() * sizeof(Char);
+    const Char* const str = s.c_str();
+    const double per_unit = measure(
+      [str]() {
+          const Char* end = str;
+          while(*end)
+              end++;
+          return static_cast<size_t>(end - str);
+      },
+      input_size);
+    const double vectorized = measure([str]() { return utf::strlen(str); }, input_size);
+    std::cout << std::setw(10) << name << std::fixed << std::setprecision(1) << std::setw(12) << per_unit << " MB/s"
+              << std::setw(12) << vectorized << " MB/s" << std::setw(8) << vectorized / per_unit << "x" << std::endl;
+}
+
+/// Compare the default error policy (replacing invalid sequences) to assuming valid input
+template<typename CharOut, typename CharIn>
+void benchmark_error_policy(const char* name, const std::basic_string<CharIn>& s)
+{
+    const size_t input_size = s.size() * sizeof(CharIn);
+    const CharIn* const begin = s.data();
+    const CharIn* const end = begin + s.size();
+    const double replace = measure(
+      [begin, end]() { return utf::convert_string<CharOut>(begin, end, utf::replace).size(); }, input_size);
+    const double assume_valid = measure(
+      [begin, end]() { return utf::convert_string<CharOut>(begin, end, utf::assume_valid).size(); }, input_size);
+    std::cout << std::setw(10) << name << std::fixed << std::setprecision(1) << std::setw(12) << replace << " MB/s"
+              << std::setw(12) << assume_valid << " MB/s" << std::setw(8) << assume_valid / replace << "x"
+              << std::endl;
+}
+
+/// Compare counting the code points of s (and the UTF-16 code units they convert to) to decoding each code point
+template<typename CharIn>
+void benchmark_count(const char* name, const std::basic_string<CharIn>& s)
+{
+    const size_t input_size = s.size() * sizeof(CharIn);
+    const CharIn* const begin = s.data();
+    const CharIn* const end = begin + s.size();
+    const double per_code_point = measure(
+      [begin, end]() {
+          size_t count = 0;
+          for(const CharIn* p = begin; p != end; ++count)
+              utf::utf_traits<CharIn>::decode(p, end);
+          return count;
+      },
+      input_size);
+    const double count = measure([begin, end]() { return utf::count_codepoints(begin, end); }, input_size);
+    const double length = measure([begin, end]() { return utf::output_length<char16_t>(begin, end); }, input_size);
+    std::cout << std::setw(10) << name << std::fixed << std::setprecision(1) << std::setw(12) << per_code_point
+              << " MB/s" << std::setw(12) << count << " MB/s" << std::setw(8) << count / per_code_point << "x"
+              << std::setw(12) << length << " MB/s" << std::setw(8) << length / per_code_point << "x" << std::endl;
+}
+
+/// Compare converting the words of s to UTF-16 one string at a time to utf::convert_batch
+void benchmark_batch(const char* name, const std::string& s)
+{
+    std::vector<std::string> words;
+    for(size_t pos = 0; pos < s.size();)
+    {
+        const size_t end = (std::min)(s.find(' ', pos), s.size());
+        words.push_back(s.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    const size_t input_size = s.size();
+    const double single = measure(
+      [&words]() {
+          size_t size = 0;
+          for(const std::string& w : words)
+              size += utf::convert_string<char16_t>(w.data(), w.data() + w.size()).size();
+          return size;
+      },
+      input_size);
+    const double batch = measure(
+      [&words]() { return utf::convert_batch<char16_t>(words.begin(), words.end()).buffer().size(); }, input_size);
+    std::cout << std::setw(10) << name << std::fixed << std::setprecision(1) << std::setw(12) << single << " MB/s"
+              << std::setw(12) << batch << " MB/s" << std::setw(8) << batch / single << "x" << std::endl;
+}
+
+template<typename CharOut>
+void benchmark_latin1(const char* name, const std::string& utf8)
+{
+    std::vector<utf::latin1_char> latin1(utf8.size() + 1);
+    if(!utf::convert_buffer(latin1.data(), latin1.size(), utf8.data(), utf8.data() + utf8.size()))
+        throw std::runtime_error("Failed to convert to Latin-1");
+    latin1.resize(utf::strlen(latin1.data()));
+    const utf::latin1_char* const begin = latin1.data();
+    const utf::latin1_char* const end = begin + latin1.size();
+    const double per_code_point = measure(
+      [begin, end]() {
+          std::basic_string<CharOut> result;
+          for(const utf::latin1_char* p = begin; p != end;)
+              utf::utf_traits<CharOut>::encode(utf::utf_traits<utf::latin1_char>::decode(p, end),
+                                               std::back_inserter(result));
+          return result.size();
+      },
+      latin1.size());
+    const double bulk = measure([begin, end]() { return utf::convert_string<CharOut>(begin, end).size(); },
+                                latin1.size());
+    std::cout << std::setw(10) << name << std::fixed << std::setprecision(1) << std::setw(12) << per_code_point
+              << " MB/s" << std::setw(12) << bulk << " MB/s" << std::setw(8) << bulk / per_code_point << "x"
+              << std::endl;
+}
+
+void print_header(const char* title)
+{
+    std::cout << "================== " << title << " ==================" << std::endl;
+    std::cout << std::setw(10) << "Corpus" << std::setw(17) << "per code point" << std::setw(17) << "convert_string"
+              << std::setw(9) << "speedup" << std::endl;
+}
+
+int main()
+{
+    try
+    {
+        const std::vector<corpus> corpora = create_corpora(8 * 1024 * 1024);
+        benchmark_decoders(corpora);
+        print_header("UTF-8 -> UTF-16");
+        for(const corpus& c : corpora)
+            benchmark<char16_t>(c.name, c.utf8);
+        print_header("UTF-8 -> UTF-32");
+        for(const corpus& c : corpora)
+            benchmark<char32_t>(c.name, c.utf8);
+        print_header("UTF-16 -> UTF-8");
+        for(const corpus& c : corpora)
+            benchmark<char>(c.name, utf::convert_string<char16_t>(c.utf8.data(), c.utf8.data() + c.utf8.size()));
+        print_header("UTF-32 -> UTF-8");
+        for(const corpus& c : corpora)
+            benchmark<char>(c.name, utf::convert_string<char32_t>(c.utf8.data(), c.utf8.data() + c.utf8.size()));
+        std::cout << "==================== utf::strlen ====================" << std::endl;
+        std::cout << std::setw(10) << "Unit" << std::setw(17) << "per unit" << std::setw(17) << "utf::strlen"
+                  << std::setw(9) << "speedup" << std::endl;
+        const std::string& text = corpora.back().utf8;
+        benchmark_strlen("UTF-8", text);
+        benchmark_strlen("UTF-16", utf::convert_string<char16_t>(text.data(), text.data() + text.size()));
+        benchmark_strlen("UTF-32", utf::convert_string<char32_t>(text.data(), text.data() + text.size()));
+        std::cout << "========= NULL terminated UTF-8 -> UTF-16 =========" << std::endl;
+        std::cout << std::setw(10) << "Corpus" << std::setw(17) << "strlen+convert" << std::setw(17) << "fused"
+                  << std::setw(9) << "speedup" << std::endl;
+        for(const corpus& c : corpora)
+            benchmark_terminated<char16_t>(c.name, c.utf8);
+        std::cout << "========= NULL terminated UTF-16 -> UTF-8 =========" << std::endl;
+        std::cout << std::setw(10) << "Corpus" << std::setw(17) << "strlen+convert" << std::setw(17) << "fused"
+                  << std::setw(9) << "speedup" << std::endl;
+        for(const corpus& c : corpora)
+            benchmark_terminated<char>(c.name,
+                                       utf::convert_string<char16_t>(c.utf8.data(), c.utf8.data() + c.utf8.size()));
+        std::cout << "========== Error policy UTF-8 -> UTF-16 ===========" << std::endl;
+        std::cout << std::setw(10) << "Corpus" << std::setw(17) << "replace" << std::setw(17) << "assume_valid"
+                  << std::setw(9) << "speedup" << std::endl;
+        for(const corpus& c : corpora)
+            benchmark_error_policy<char16_t>(c.name, c.utf8);
+        std::cout << "========== Error policy UTF-16 -> UTF-8 ===========" << std::endl;
+        std::cout << std::setw(10) << "Corpus" << std::setw(17) << "replace" << std::setw(17) << "assume_valid"
+                  << std::setw(9) << "speedup" << std::endl;
+        for(const corpus& c : corpora)
+            benchmark_error_policy<char>(c.name,
+                                         utf::convert_string<char16_t>(c.utf8.data(), c.utf8.data() + c.utf8.size()));
+        std::cout << "=============== Counting UTF-8 code points ===============" << std::endl;
+        std::cout << std::setw(10) << "Corpus" << std::setw(17) << "per code point" << std::setw(17)
+                  << "count_codepoints" << std::setw(9) << "speedup" << std::setw(17) << "output_length" << std::setw(9)
+                  << "speedup" << std::endl;
+        for(const corpus& c : corpora)
+            benchmark_count(c.name, c.utf8);
+        std::cout << "=========== Words UTF-8 -> UTF-16 ===========" << std::endl;
+        std::cout << std::setw(10) << "Corpus" << std::setw(17) << "convert_string" << std::setw(17) << "convert_batch"
+                  << std::setw(9) << "speedup" << std::endl;
+        for(const corpus& c : corpora)
+            benchmark_batch(c.name, c.utf8);
+        print_header("Latin-1 -> UTF-8");
+        benchmark_latin1<char>(corpora[0].name, corpora[0].utf8);
+        benchmark_latin1<char>(corpora[1].name, corpora[1].utf8);
+        print_header("Latin-1 -> UTF-16");
+        benchmark_latin1<char16_t>(corpora[0].name, corpora[0].utf8);
+        benchmark_latin1<char16_t>(corpora[1].name, corpora[1].utf8);
+    } catch(const std::runtime_error& err)
+    {
+        std::cerr << "Benchmarking failed: " << err.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
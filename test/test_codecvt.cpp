@@ -311,10 +311,23 @@ void test_codecvt_subst()
     run_all(codecvt_to_wide, codecvt_to_narrow);
 }
 
+void test_codecvt_long_strings()
+{
+    std::cout << "Long strings " << std::endl;
+    for(unsigned seed = 0; seed < 100; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        TEST(codecvt_to_wide(s) == convert_reference<wchar_t>(s));
+        const std::wstring ws = create_wide_test_string<wchar_t>(seed, 1 + seed % 50);
+        TEST(codecvt_to_narrow(ws) == convert_reference<char>(ws));
+    }
+}
+
 // coverity [root_function]
 void test_main(int, char**, char**)
 {
     test_codecvt_conv();
     test_codecvt_err();
     test_codecvt_subst();
+    test_codecvt_long_strings();
 }
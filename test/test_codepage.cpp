@@ -0,0 +1,245 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/nowide/utf/codepage.hpp>
+#include <boost/nowide/utf/convert.hpp>
+#include <boost/nowide/utf/validate.hpp>
+#include "test.hpp"
+#include "test_sets.hpp"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using boost::nowide::utf::code_point;
+using boost::nowide::utf::cp1252_char;
+using boost::nowide::utf::latin1_char;
+namespace utf = boost::nowide::utf;
+
+/// Code points of the bytes 0x80-0x9F of Windows-1252 as listed by the WHATWG Encoding Standard
+const code_point cp1252_reference[32] = {0x20AC, 0x81,   0x201A, 0x192,  0x201E, 0x2026, 0x2020, 0x2021,
+                                         0x2C6,  0x2030, 0x160,  0x2039, 0x152,  0x8D,   0x17D,  0x8F,
+                                         0x90,   0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+                                         0x2DC,  0x2122, 0x161,  0x203A, 0x153,  0x9D,   0x17E,  0x178};
+
+code_point to_code_point(latin1_char c)
+{
+    return static_cast<unsigned char>(c);
+}
+code_point to_code_point(cp1252_char c)
+{
+    const unsigned char b = static_cast<unsigned char>(c);
+    return (b >= 0x80 && b < 0xA0) ? cp1252_reference[b - 0x80] : b;
+}
+
+/// Reference conversion encoding the code point of each byte individually
+template<typename CharOut, typename CharIn>
+std::basic_string<CharOut> reference_convert(const std::vector<CharIn>& s)
+{
+    std::basic_string<CharOut> result;
+    for(const CharIn c : s)
+        utf::utf_traits<CharOut>::encode(to_code_point(c), std::back_inserter(result));
+    return result;
+}
+
+template<typename CharOut, typename CharIn>
+std::basic_string<CharOut> convert(const std::vector<CharIn>& s)
+{
+    return utf::convert_string<CharOut>(s.data(), s.data() + s.size());
+}
+
+/// Convert to UTF-8/16/32 and back and compare with the reference
+template<typename CharIn>
+void test_roundtrip(const std::vector<CharIn>& s)
+{
+    const std::string utf8 = reference_convert<char>(s);
+    TEST(convert<char>(s) == utf8);
+    TEST(convert<char16_t>(s) == reference_convert<char16_t>(s));
+    TEST(convert<char32_t>(s) == reference_convert<char32_t>(s));
+    TEST(convert<wchar_t>(s) == reference_convert<wchar_t>(s));
+    TEST_EQ(utf::output_length<char>(s.data(), s.data() + s.size()), utf8.size());
+    TEST_EQ(utf::output_length<char16_t>(s.data(), s.data() + s.size()), s.size());
+    TEST_EQ(utf::count_codepoints(s.data(), s.data() + s.size()), s.size());
+
+    std::vector<CharIn> back(s.size() + 1);
+    TEST(utf::convert_buffer(back.data(), back.size(), utf8.data(), utf8.data() + utf8.size()) == back.data());
+    TEST(std::equal(s.begin(), s.end(), back.begin()));
+    const std::u16string utf16 = reference_convert<char16_t>(s);
+    TEST(utf::convert_buffer(back.data(), back.size(), utf16.data(), utf16.data() + utf16.size()) == back.data());
+    TEST(std::equal(s.begin(), s.end(), back.begin()));
+    const std::u32string utf32 = reference_convert<char32_t>(s);
+    TEST(utf::convert_buffer(back.data(), back.size(), utf32.data(), utf32.data() + utf32.size()) == back.data());
+    TEST(std::equal(s.begin(), s.end(), back.begin()));
+    // Too small
+    if(!s.empty())
+        TEST(!utf::convert_buffer(back.data(), back.size() - 1, utf32.data(), utf32.data() + utf32.size()));
+}
+
+/// Return a string of num_bytes bytes, mostly ASCII with some non-ASCII ones or runs of them
+template<typename CharIn>
+std::vector<CharIn> create_test_string(unsigned seed, size_t num_bytes)
+{
+    std::minstd_rand rng(seed + 1);
+    std::vector<CharIn> result;
+    while(result.size() < num_bytes)
+    {
+        const size_t run_length = std::min<size_t>(1 + rng() % 40, num_bytes - result.size());
+        const unsigned kind = rng() % 4;
+        for(size_t i = 0; i < run_length; i++)
+        {
+            const unsigned c = (kind == 0) ? 0x80 + rng() % 0x80 : (kind == 1) ? rng() % 0x100 : 0x20 + rng() % 0x5F;
+            result.push_back(static_cast<CharIn>(c));
+        }
+    }
+    return result;
+}
+
+template<typename CharIn>
+void test_all_bytes()
+{
+    std::vector<CharIn> s;
+    for(unsigned i = 1; i < 0x100; i++)
+        s.push_back(static_cast<CharIn>(i));
+    test_roundtrip(s);
+    // Each byte at each position of a block
+    for(unsigned i = 0x80; i < 0x100; i++)
+    {
+        for(size_t pos = 0; pos < 70; pos += 7)
+        {
+            std::vector<CharIn> t(70, static_cast<CharIn>('a'));
+            t[pos] = static_cast<CharIn>(i);
+            test_roundtrip(t);
+        }
+    }
+}
+
+void test_latin1()
+{
+    const std::vector<latin1_char> s = {static_cast<latin1_char>('a'),
+                                        static_cast<latin1_char>(0xE4),
+                                        static_cast<latin1_char>(0x80),
+                                        static_cast<latin1_char>(0xFF)};
+    TEST(convert<char>(s) == "a\xc3\xa4\xc2\x80\xc3\xbf");
+    TEST(convert<char16_t>(s) == u"a\u00e4\u0080\u00ff");
+    test_all_bytes<latin1_char>();
+
+    // Code points not in Latin-1 are replaced by '?' and counted
+    const std::u16string utf16 = u"\u00e4\u20ac\U0001F600" "b";
+    latin1_char buf[16];
+    TEST(utf::convert_buffer(buf, 16, utf16.data(), utf16.data() + utf16.size()) == buf);
+    TEST_EQ(utf::strlen(buf), 4u);
+    TEST_EQ(buf[0], static_cast<latin1_char>(0xE4));
+    TEST_EQ(buf[1], static_cast<latin1_char>('?'));
+    TEST_EQ(buf[2], static_cast<latin1_char>('?'));
+    TEST_EQ(buf[3], static_cast<latin1_char>('b'));
+    utf::convert_result result = utf::convert(buf, 16, utf16.data(), utf16.data() + utf16.size());
+    TEST(result.complete());
+    TEST_EQ(result.written, 4u);
+    TEST_EQ(result.replacements, 2u);
+    result = utf::convert(static_cast<latin1_char*>(nullptr), 0, utf16.c_str());
+    TEST_EQ(result.required, 4u);
+    TEST_EQ(result.replacements, 2u);
+    // ... or are an error with utf::strict
+    result = utf::convert(buf, 16, utf16.data(), utf16.data() + utf16.size(), utf::strict);
+    TEST(!result.complete());
+    TEST_EQ(result.consumed, 1u);
+    TEST_EQ(result.written, 1u);
+    TEST_EQ(result.required, 1u);
+    TEST_EQ(result.error, utf::illegal);
+    result = utf::convert(buf, 16, utf16.c_str(), utf::strict);
+    TEST_EQ(result.consumed, 1u);
+    TEST_EQ(result.error, utf::illegal);
+    bool thrown = false;
+    try
+    {
+        utf::convert_string<latin1_char>(utf16.data(), utf16.data() + utf16.size(), utf::strict);
+    } catch(const utf::conversion_error& err)
+    {
+        thrown = true;
+        TEST_EQ(err.offset(), 1u);
+        TEST_EQ(err.error(), utf::illegal);
+    }
+    TEST(thrown);
+    // Invalid UTF-8 is replaced first
+    const std::string utf8 = "\xc3\xa4\xff" "a";
+    TEST(utf::convert_buffer(buf, 16, utf8.data(), utf8.data() + utf8.size()) == buf);
+    TEST_EQ(utf::strlen(buf), 3u);
+    TEST_EQ(buf[1], static_cast<latin1_char>('?'));
+    thrown = false;
+    try
+    {
+        utf::convert_buffer(buf, 16, utf8.data(), utf8.data() + utf8.size(), utf::strict);
+    } catch(const utf::conversion_error& err)
+    {
+        thrown = true;
+        TEST_EQ(err.offset(), 2u);
+    }
+    TEST(thrown);
+
+    // NULL terminated input
+    const latin1_char terminated[] = {static_cast<latin1_char>(0xE9), static_cast<latin1_char>('t'),
+                                      static_cast<latin1_char>(0xE9), static_cast<latin1_char>(0)};
+    TEST(utf::convert_string<char>(terminated) == "\xc3\xa9t\xc3\xa9");
+    TEST(utf::convert_string<wchar_t>(terminated) == L"\u00e9t\u00e9");
+}
+
+void test_cp1252()
+{
+    const std::vector<cp1252_char> s = {static_cast<cp1252_char>(0x80),
+                                        static_cast<cp1252_char>('1'),
+                                        static_cast<cp1252_char>(0x81),
+                                        static_cast<cp1252_char>(0x9F),
+                                        static_cast<cp1252_char>(0xA0)};
+    TEST(convert<char>(s) == "\xe2\x82\xac"
+                             "1\xc2\x81\xc5\xb8\xc2\xa0");
+    TEST(convert<char32_t>(s) == U"\u20ac" "1\u0081\u0178\u00a0");
+    test_all_bytes<cp1252_char>();
+
+    // U+0080 is not in Windows-1252 but U+0081 is
+    const std::u32string utf32 = U"\u0080\u0081\u20ac\u0152\u00ff\u0100";
+    cp1252_char buf[16];
+    TEST(utf::convert_buffer(buf, 16, utf32.data(), utf32.data() + utf32.size()) == buf);
+    TEST_EQ(buf[0], static_cast<cp1252_char>('?'));
+    TEST_EQ(buf[1], static_cast<cp1252_char>(0x81));
+    TEST_EQ(buf[2], static_cast<cp1252_char>(0x80));
+    TEST_EQ(buf[3], static_cast<cp1252_char>(0x8C));
+    TEST_EQ(buf[4], static_cast<cp1252_char>(0xFF));
+    TEST_EQ(buf[5], static_cast<cp1252_char>('?'));
+    TEST_EQ(utf::convert(buf, 16, utf32.data(), utf32.data() + utf32.size()).replacements, 2u);
+    TEST_EQ(utf::convert(buf, 16, utf32.data(), utf32.data() + utf32.size(), utf::strict).consumed, 0u);
+    TEST_EQ(utf::convert(buf, 16, utf32.data() + 1, utf32.data() + utf32.size(), utf::strict).consumed, 4u);
+
+    // Between codepages
+    const std::vector<latin1_char> latin1 = {static_cast<latin1_char>(0xE4), static_cast<latin1_char>(0x80)};
+    TEST(utf::convert_buffer(buf, 16, latin1.data(), latin1.data() + latin1.size()) == buf);
+    TEST_EQ(buf[0], static_cast<cp1252_char>(0xE4));
+    TEST_EQ(buf[1], static_cast<cp1252_char>('?'));
+    TEST_EQ(utf::convert(buf, 16, latin1.data(), latin1.data() + latin1.size()).replacements, 1u);
+    TEST_EQ(utf::convert(buf, 16, latin1.data(), latin1.data() + latin1.size(), utf::strict).error, utf::illegal);
+}
+
+void test_long_strings()
+{
+    for(unsigned seed = 0; seed < 100; seed++)
+    {
+        test_roundtrip(create_test_string<latin1_char>(seed, seed * 7));
+        test_roundtrip(create_test_string<cp1252_char>(seed, seed * 7));
+    }
+}
+
+// coverity [root_function]
+void test_main(int, char**, char**)
+{
+    std::cout << "- Latin-1" << std::endl;
+    test_latin1();
+    std::cout << "- Windows-1252" << std::endl;
+    test_cp1252();
+    std::cout << "- Long strings" << std::endl;
+    test_long_strings();
+}
@@ -0,0 +1,114 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/nowide/utf/codepoint_index.hpp>
+#include "test.hpp"
+#include "test_sets.hpp"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using boost::nowide::utf::codepoint_index;
+
+/// Offsets of the code units starting a code point, i.e. which are not trails
+template<typename CharIn>
+std::vector<size_t> code_point_offsets(const std::basic_string<CharIn>& s)
+{
+    std::vector<size_t> result;
+    for(size_t i = 0; i < s.size(); i++)
+    {
+        if(!boost::nowide::utf::utf_traits<CharIn>::is_trail(s[i]))
+            result.push_back(i);
+    }
+    return result;
+}
+
+/// Check all lookups of an index of s against the offsets computed one by one
+template<typename CharIn>
+void check_index(const codepoint_index<CharIn>& index, const std::basic_string<CharIn>& s)
+{
+    const std::vector<size_t> offsets = code_point_offsets(s);
+    TEST_EQ(index.size(), offsets.size());
+    TEST_EQ(index.units(), s.size());
+    for(size_t i = 0; i < offsets.size(); i++)
+        TEST_EQ(index.offset(s.data(), i), offsets[i]);
+    TEST_EQ(index.offset(s.data(), offsets.size()), s.size());
+    for(size_t i = 0; i < s.size(); i++)
+    {
+        // Index of the last code point starting at or before i, trails before the first one belong to it
+        const auto next = std::upper_bound(offsets.begin(), offsets.end(), i);
+        const size_t num_started = static_cast<size_t>(next - offsets.begin());
+        TEST_EQ(index.code_point_at(s.data(), i), num_started == 0 ? 0 : num_started - 1);
+    }
+}
+
+/// Build indices of s with different intervals, at once and in random chunks
+template<typename CharIn>
+void test_index(const std::basic_string<CharIn>& s, unsigned seed)
+{
+    std::minstd_rand rng(seed + 1);
+    for(size_t interval : {1, 2, 3, 16, 100, 1024})
+    {
+        check_index(codepoint_index<CharIn>(s.data(), s.data() + s.size(), interval), s);
+        codepoint_index<CharIn> index(interval);
+        for(size_t pos = 0; pos < s.size();)
+        {
+            const size_t chunk_size = std::min<size_t>(1 + rng() % 700, s.size() - pos);
+            index.append(s.data() + pos, s.data() + pos + chunk_size);
+            pos += chunk_size;
+        }
+        check_index(index, s);
+        index.clear();
+        check_index(index, std::basic_string<CharIn>());
+    }
+}
+
+void test_simple()
+{
+    const std::string empty;
+    test_index(empty, 0);
+    const auto index = boost::nowide::utf::make_codepoint_index(empty);
+    TEST_EQ(index.size(), 0u);
+    TEST_EQ(index.offset(empty.data(), 0), 0u);
+
+    const std::string s = "a\xd7\xa9\xe3\x82\x84\xf0\x9d\x92\x9e" "b";
+    const auto index2 = boost::nowide::utf::make_codepoint_index(s, 2);
+    TEST_EQ(index2.size(), 5u);
+    TEST_EQ(index2.interval(), 2u);
+    TEST_EQ(index2.offset(s.data(), 3), 6u);
+    TEST_EQ(index2.code_point_at(s.data(), 8), 3u);
+    test_index(s, 0);
+    // Leading and stray trails
+    test_index(std::string("\x80\x80" "a\x80\xd7\xa9\x80" "b"), 0);
+    test_index(std::u16string(u"\xDC00" "a\xD800\xDC00\xDC00"), 0);
+}
+
+void test_long_strings()
+{
+    std::string s;
+    std::u16string s16;
+    for(unsigned seed = 0; seed < 30; seed++)
+    {
+        s += create_utf8_test_string(seed, 20);
+        s16 += create_wide_test_string<char16_t>(seed, 20);
+    }
+    test_index(s, 1);
+    test_index(s16, 2);
+    test_index(create_wide_test_string<char32_t>(3, 50), 3);
+}
+
+// coverity [root_function]
+void test_main(int, char**, char**)
+{
+    std::cout << "- Simple cases" << std::endl;
+    test_simple();
+    std::cout << "- Long strings" << std::endl;
+    test_long_strings();
+}
@@ -0,0 +1,166 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/nowide/utf/codepoint_view.hpp>
+#include "test.hpp"
+#include "test_sets.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using boost::nowide::utf::code_point;
+using boost::nowide::utf::make_codepoint_view;
+using boost::nowide::utf::make_encode_iterator;
+
+/// Iterate over the code points of s forward and backward and check that both visit the same positions and values.
+/// For valid input they are the decoded code points.
+template<typename CharIn>
+void test_view(const std::basic_string<CharIn>& s, bool is_valid)
+{
+    const auto view = make_codepoint_view(s);
+    TEST_EQ(view.empty(), s.empty());
+    std::vector<code_point> forward;
+    std::vector<const CharIn*> positions;
+    for(auto it = view.begin(); it != view.end(); ++it)
+    {
+        forward.push_back(*it);
+        positions.push_back(it.base());
+    }
+    TEST_EQ(positions.size(), static_cast<size_t>(std::distance(view.begin(), view.end())));
+    std::vector<code_point> backward(view.rbegin(), view.rend());
+    std::reverse(backward.begin(), backward.end());
+    TEST(forward == backward);
+    auto it = view.end();
+    for(size_t i = positions.size(); i > 0; i--)
+    {
+        --it;
+        TEST(it.base() == positions[i - 1]);
+    }
+    TEST(it == view.begin());
+
+    if(is_valid)
+    {
+        const std::u32string ref = convert_reference<char32_t>(s);
+        TEST(std::u32string(forward.begin(), forward.end()) == ref);
+    }
+    // Each code unit not being part of a valid sequence is replaced on its own
+    size_t num_units = 0;
+    for(size_t i = 0; i < positions.size(); i++)
+    {
+        const CharIn* next = (i + 1 < positions.size()) ? positions[i + 1] : s.data() + s.size();
+        const CharIn* p = positions[i];
+        const code_point c = boost::nowide::utf::utf_traits<CharIn>::decode(p, next);
+        if(c == boost::nowide::utf::illegal || c == boost::nowide::utf::incomplete)
+        {
+            TEST_EQ(next - positions[i], 1);
+            TEST_EQ(forward[i], static_cast<code_point>(BOOST_NOWIDE_REPLACEMENT_CHARACTER));
+        } else
+        {
+            TEST(p == next);
+            TEST_EQ(forward[i], c);
+        }
+        num_units += static_cast<size_t>(next - positions[i]);
+    }
+    TEST_EQ(num_units, s.size());
+}
+
+/// Transcode s via a codepoint_view and an encode_iterator
+template<typename CharOut, typename CharIn>
+std::basic_string<CharOut> transcode_view(const std::basic_string<CharIn>& s)
+{
+    const auto view = make_codepoint_view(s);
+    std::basic_string<CharOut> result;
+    std::copy(view.begin(), view.end(), make_encode_iterator<CharOut>(std::back_inserter(result)));
+    return result;
+}
+
+void test_simple()
+{
+    test_view(std::string(), true);
+    test_view(std::u16string(), true);
+    const std::string hello = "Hello \xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xf0\x9d\x92\x9e!";
+    test_view(hello, true);
+    std::u32string hello32 = U"Hello \u05e9\u05dc\u05d5\u05dd \U0001D49E!";
+    TEST(transcode_view<char32_t>(hello) == hello32);
+    TEST(transcode_view<char16_t>(hello) == u"Hello \u05e9\u05dc\u05d5\u05dd \U0001D49E!");
+    TEST(transcode_view<char>(hello32) == hello);
+    test_view(hello32, true);
+    test_view(transcode_view<wchar_t>(hello), true);
+
+    // Incomplete sequences: The following delimiter is still found
+    const std::string fields = "a\xe2\x82;b\xf0;\xd7\xa9";
+    const auto view = make_codepoint_view(fields);
+    TEST_EQ(std::count(view.begin(), view.end(), code_point(';')), 2);
+    TEST(transcode_view<char32_t>(fields) == U"a\uFFFD\uFFFD;b\uFFFD;\u05e9");
+    test_view(fields, false);
+    // Overlong and surrogate encodings, stray trail and invalid bytes
+    test_view(std::string("\xc0\x80\xe0\x80\x80\xed\xa0\x80\x80\xff\xf4\x90\x80\x80x"), false);
+    // Lone surrogates
+    const std::u16string s16 = u"a\xD800" "b\xDC00\xD800\xDC00\xDC00\xD800";
+    test_view(s16, false);
+    TEST(transcode_view<char32_t>(s16) == U"a\uFFFDb\uFFFD\U00010000\uFFFD\uFFFD");
+
+    // Invalid code points are replaced when encoding
+    std::u16string out;
+    auto encoder = make_encode_iterator<char16_t>(std::back_inserter(out));
+    *encoder++ = 0x41;
+    *encoder++ = 0xD800;
+    *encoder++ = 0x110000;
+    *encoder++ = 0x10000;
+    TEST(out == u"A\uFFFD\uFFFD\U00010000");
+    char buf[8];
+    auto encoder8 = make_encode_iterator<char>(buf);
+    *encoder8 = 0x20AC;
+    TEST_EQ(encoder8.base() - buf, 3);
+}
+
+void test_skip_ascii()
+{
+    const std::string s = std::string(100, 'a') + "\xd7\xa9" + std::string(50, 'b');
+    const auto view = make_codepoint_view(s);
+    auto it = view.begin();
+    it.skip_ascii();
+    TEST(it.base() == s.data() + 100);
+    TEST_EQ(*it, 0x5e9u);
+    TEST(it.skip_ascii().base() == s.data() + 100);
+    ++it;
+    TEST(it.skip_ascii() == view.end());
+
+    const std::u16string s16 = u"abc\u00e4d";
+    auto it16 = make_codepoint_view(s16).begin();
+    TEST(it16.skip_ascii().base() == s16.data() + 3);
+}
+
+void test_long_strings()
+{
+    for(unsigned seed = 0; seed < 50; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        test_view(s, false);
+        // Valid by round-tripping through the conversion
+        const std::string valid = convert_reference<char>(convert_reference<char32_t>(s));
+        test_view(valid, true);
+        TEST(transcode_view<char16_t>(valid) == convert_reference<char16_t>(valid));
+        TEST(transcode_view<char32_t>(s) == convert_reference<char32_t>(transcode_view<char>(s)));
+        test_view(create_wide_test_string<char16_t>(seed, 1 + seed % 50), false);
+        test_view(create_wide_test_string<char32_t>(seed, 1 + seed % 50), false);
+    }
+}
+
+// coverity [root_function]
+void test_main(int, char**, char**)
+{
+    std::cout << "- Simple cases" << std::endl;
+    test_simple();
+    std::cout << "- Skipping ASCII" << std::endl;
+    test_skip_ascii();
+    std::cout << "- Long strings" << std::endl;
+    test_long_strings();
+}
@@ -6,12 +6,23 @@
 //  http://www.boost.org/LICENSE_1_0.txt)
 //
 
+// Count the input consumed by the bulk kernels to check they are actually used
+#define BOOST_NOWIDE_TEST_COUNT_BULK
 #include <boost/nowide/convert.hpp>
 #include "test.hpp"
 #include "test_sets.hpp"
+#include <algorithm>
 #include <array>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #ifdef __cpp_lib_string_view
 #include <string_view>
@@ -114,6 +125,56 @@ ASSERT_RETURN_TYPE(boost::nowide::widen, char8_t, std::wstring);
 ASSERT_RETURN_TYPE(boost::nowide::narrow, wchar_t, std::string);
 ASSERT_RETURN_TYPE(boost::nowide::narrow, char16_t, std::string);
 ASSERT_RETURN_TYPE(boost::nowide::narrow, char32_t, std::string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u16string, char, std::u16string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u16string, wchar_t, std::u16string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u16string, char16_t, std::u16string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u16string, char32_t, std::u16string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u32string, char, std::u32string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u32string, wchar_t, std::u32string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u32string, char16_t, std::u32string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u32string, char32_t, std::u32string);
+#ifdef __cpp_lib_char8_t
+ASSERT_RETURN_TYPE(boost::nowide::to_u8string, char, std::u8string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u8string, char8_t, std::u8string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u8string, wchar_t, std::u8string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u8string, char16_t, std::u8string);
+ASSERT_RETURN_TYPE(boost::nowide::to_u8string, char32_t, std::u8string);
+#endif
+
+#ifndef BOOST_NO_CXX14_CONSTEXPR
+static_assert(boost::nowide::utf::is_valid_codepoint(0x10FFFF) && !boost::nowide::utf::is_valid_codepoint(0xD800), "");
+static_assert(boost::nowide::utf::utf_traits<char>::width(0x10000) == 4, "");
+static_assert(boost::nowide::utf::utf_traits<char16_t>::width(0x10000) == 2, "");
+static_assert(boost::nowide::utf::strlen(u"abc") == 3, "");
+constexpr boost::nowide::utf::code_point decode_dfa_at_compile_time(const char* s, int n)
+{
+    return boost::nowide::utf::utf_traits<char>::decode_dfa(s, s + n);
+}
+static_assert(decode_dfa_at_compile_time("\xf0\x90\x8c\xbc", 4) == 0x1033C, "");
+static_assert(decode_dfa_at_compile_time("\xed\xa0\x80", 3) == boost::nowide::utf::illegal, "");
+
+constexpr auto literal_wide = boost::nowide::utf::convert_literal<wchar_t>("\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d");
+static_assert(literal_wide.size() == 4 && literal_wide[0] == 0x05e9 && literal_wide[3] == 0x05dd, "");
+static_assert(literal_wide.c_str()[4] == 0, "NULL terminated");
+constexpr auto literal_utf8 = boost::nowide::utf::convert_literal<char>(u"\u05e9\U0001033C");
+static_assert(literal_utf8.size() == 6 && literal_utf8[2] == '\xf0' && literal_utf8[5] == '\xbc', "");
+constexpr auto literal_invalid = boost::nowide::utf::convert_literal<char16_t>("a\xff");
+static_assert(literal_invalid.size() == 2 && literal_invalid[1] == BOOST_NOWIDE_REPLACEMENT_CHARACTER, "");
+constexpr auto literal_utf16 = boost::nowide::utf::convert_literal<char16_t>(U"\U0001033Cb");
+static_assert(literal_utf16.size() == 3 && literal_utf16[0] == 0xD800 && literal_utf16[2] == u'b', "");
+#endif
+
+#ifndef BOOST_NOWIDE_NO_CONSTEXPR_CONVERT
+constexpr bool convert_buffer_at_compile_time()
+{
+    const char s[] = "\xd7\xa9xy\xff";
+    char16_t buf[5] = {};
+    return boost::nowide::utf::convert_buffer(buf, 5, s, s + 5) == buf && buf[0] == 0x05e9 && buf[2] == u'y'
+           && buf[3] == BOOST_NOWIDE_REPLACEMENT_CHARACTER && buf[4] == 0
+           && boost::nowide::utf::convert_buffer(buf, 4, s, s + 5) == nullptr;
+}
+static_assert(convert_buffer_at_compile_time(), "");
+#endif
 
 #ifdef BOOST_NOWIDE_TEST_STD_STRINGVIEW
 std::wstring widen_string_view(const std::string& s)
@@ -127,6 +188,672 @@ std::string narrow_string_view(const std::wstring& s)
 }
 #endif
 
+std::wstring widen_into(const std::string& s)
+{
+    // Existing content is replaced
+    std::wstring out = L"Previous content";
+    TEST(&boost::nowide::widen_into(out, s) == &out);
+    return out;
+}
+
+std::string narrow_into(const std::wstring& s)
+{
+    std::string out = "Previous content";
+    TEST(&boost::nowide::narrow_into(out, s) == &out);
+    return out;
+}
+
+std::wstring widen_append(const std::string& s)
+{
+    std::wstring out = L"Prefix";
+    TEST(&boost::nowide::widen_append(out, s.c_str()) == &out);
+    TEST(out.compare(0, 6, L"Prefix") == 0);
+    return out.substr(6);
+}
+
+std::string narrow_append(const std::wstring& s)
+{
+    std::string out = "Prefix";
+    TEST(&boost::nowide::narrow_append(out, s.c_str()) == &out);
+    TEST(out.compare(0, 6, "Prefix") == 0);
+    return out.substr(6);
+}
+
+void test_convert_into()
+{
+    const std::string hello = "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d";
+    const std::wstring whello = L"\u05e9\u05dc\u05d5\u05dd";
+    std::string out;
+    std::wstring wout;
+    out.reserve(100);
+    wout.reserve(100);
+    const char* const data = out.data();
+    const wchar_t* const wdata = wout.data();
+    // The capacity is reused if it is large enough
+    for(int i = 0; i < 3; i++)
+    {
+        TEST(boost::nowide::narrow_into(out, whello) == hello);
+        TEST(out.data() == data);
+        TEST(boost::nowide::widen_into(wout, hello) == whello);
+        TEST(wout.data() == wdata);
+    }
+    TEST(boost::nowide::narrow_into(out, whello.c_str(), 2) == hello.substr(0, 4));
+    TEST(boost::nowide::widen_into(wout, hello.c_str(), 4) == whello.substr(0, 2));
+    TEST(boost::nowide::narrow_append(out, whello.c_str() + 2, 2) == hello);
+    TEST(boost::nowide::widen_append(wout, hello.c_str() + 4, 4) == whello);
+    TEST(boost::nowide::narrow_append(out, u"\u05e9") == hello + "\xd7\xa9");
+    TEST(boost::nowide::narrow_append(out, std::u32string(U"\U0001033C")) == hello + "\xd7\xa9\xf0\x90\x8c\xbc");
+    TEST(out.data() == data);
+    // Empty input
+    TEST(boost::nowide::widen_into(wout, "").empty());
+    TEST(boost::nowide::narrow_append(out, L"", 0) == hello + "\xd7\xa9\xf0\x90\x8c\xbc");
+    // Growing keeps the existing content
+    std::string s(200, 'x');
+    std::wstring ws(200, L'x');
+    TEST(boost::nowide::narrow_append(out, ws) == hello + "\xd7\xa9\xf0\x90\x8c\xbc" + s);
+    TEST(boost::nowide::widen_append(wout, s) == ws);
+#ifdef BOOST_NOWIDE_TEST_STD_STRINGVIEW
+    TEST(boost::nowide::widen_into(wout, std::string_view(hello)) == whello);
+    TEST(boost::nowide::narrow_append(out.erase(), std::wstring_view(whello)) == hello);
+#endif
+}
+
+template<typename CharOut>
+void test_bulk_conversion(const std::string& s)
+{
+    using boost::nowide::utf::convert_buffer;
+    using boost::nowide::utf::convert_string;
+    const std::basic_string<CharOut> ref = convert_reference<CharOut>(s);
+    TEST_EQ(boost::nowide::utf::output_length<CharOut>(s.data(), s.data() + s.size()), ref.size());
+    TEST(convert_string<CharOut>(s.data(), s.data() + s.size()) == ref);
+    std::vector<CharOut> buf(ref.size() + 2, CharOut(42));
+    TEST(convert_buffer(buf.data(), ref.size() + 1, s.data(), s.data() + s.size()) == buf.data());
+    TEST(std::basic_string<CharOut>(buf.data()) == ref);
+    TEST(buf.back() == CharOut(42));
+    TEST(convert_buffer(buf.data(), ref.size(), s.data(), s.data() + s.size()) == nullptr);
+}
+
+template<typename CharIn>
+void test_bulk_conversion_to_utf8(const std::basic_string<CharIn>& s)
+{
+    using boost::nowide::utf::convert_buffer;
+    using boost::nowide::utf::convert_string;
+    const std::string ref = convert_reference<char>(s);
+    TEST_EQ(boost::nowide::utf::output_length<char>(s.data(), s.data() + s.size()), ref.size());
+    TEST(convert_string<char>(s.data(), s.data() + s.size()) == ref);
+    std::vector<char> buf(ref.size() + 2, 42);
+    TEST(convert_buffer(buf.data(), ref.size() + 1, s.data(), s.data() + s.size()) == buf.data());
+    TEST(std::string(buf.data()) == ref);
+    TEST(buf.back() == 42);
+    TEST(convert_buffer(buf.data(), ref.size(), s.data(), s.data() + s.size()) == nullptr);
+}
+
+/// UTF-16 <-> UTF-32
+template<typename CharOut, typename CharIn>
+void test_bulk_wide_conversion(const std::basic_string<CharIn>& s)
+{
+    using boost::nowide::utf::convert_buffer;
+    using boost::nowide::utf::convert_string;
+    const std::basic_string<CharOut> ref = convert_reference<CharOut>(s);
+    TEST_EQ(boost::nowide::utf::output_length<CharOut>(s.data(), s.data() + s.size()), ref.size());
+    TEST(convert_string<CharOut>(s.data(), s.data() + s.size()) == ref);
+    std::vector<CharOut> buf(ref.size() + 2, CharOut(42));
+    TEST(convert_buffer(buf.data(), ref.size() + 1, s.data(), s.data() + s.size()) == buf.data());
+    TEST(std::basic_string<CharOut>(buf.data()) == ref);
+    TEST(buf.back() == CharOut(42));
+    TEST(convert_buffer(buf.data(), ref.size(), s.data(), s.data() + s.size()) == nullptr);
+}
+
+/// Count the invalid sequences using only the code point wise decode
+template<typename CharIn>
+size_t count_replacements(const std::basic_string<CharIn>& s)
+{
+    using namespace boost::nowide::utf;
+    size_t count = 0;
+    for(const CharIn* p = s.data(); p != s.data() + s.size();)
+    {
+        const code_point c = utf_traits<CharIn>::decode(p, s.data() + s.size());
+        if(c == illegal || c == incomplete)
+            ++count;
+    }
+    return count;
+}
+
+/// Convert s in chunks of at most chunk_size code units via utf::convert
+template<typename CharOut, typename CharIn>
+void test_convert_chunked(const std::basic_string<CharIn>& s, size_t chunk_size)
+{
+    using boost::nowide::utf::convert;
+    using boost::nowide::utf::convert_result;
+    const std::basic_string<CharOut> ref = convert_reference<CharOut>(s);
+    const size_t num_replacements = count_replacements(s);
+
+    // Size query
+    const convert_result query = convert(static_cast<CharOut*>(nullptr), 0, s.data(), s.data() + s.size());
+    TEST_EQ(query.consumed, 0u);
+    TEST_EQ(query.written, 0u);
+    TEST_EQ(query.required, ref.size());
+    TEST_EQ(query.replacements, num_replacements);
+    TEST_EQ(query.complete(), s.empty());
+
+    std::vector<CharOut> buf(chunk_size + 1, CharOut(42));
+    std::basic_string<CharOut> result;
+    const CharIn* begin = s.data();
+    const CharIn* const end = begin + s.size();
+    convert_result r;
+    do
+    {
+        r = convert(buf.data(), chunk_size, begin, end);
+        TEST(r.written <= chunk_size);
+        TEST_EQ(r.required, ref.size() - result.size());
+        TEST(buf[chunk_size] == CharOut(42));
+        // Nothing converted only if the next code point doesn't fit
+        TEST(r.consumed > 0 || r.complete() || chunk_size < 4);
+        if(r.consumed == 0 && !r.complete())
+            return;
+        result.append(buf.data(), r.written);
+        begin += r.consumed;
+    } while(!r.complete());
+    TEST(begin == end);
+    TEST(result == ref);
+}
+
+void test_convert_result()
+{
+    for(unsigned seed = 0; seed < 50; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        const std::u16string s16 = create_wide_test_string<char16_t>(seed, 1 + seed % 50);
+        const std::u32string s32 = create_wide_test_string<char32_t>(seed, 1 + seed % 50);
+        for(size_t chunk_size : {1, 3, 4, 17, 64, 1000})
+        {
+            test_convert_chunked<char16_t>(s, chunk_size);
+            test_convert_chunked<char32_t>(s, chunk_size);
+            test_convert_chunked<char>(s16, chunk_size);
+            test_convert_chunked<char>(s32, chunk_size);
+            test_convert_chunked<char32_t>(s16, chunk_size);
+            test_convert_chunked<char16_t>(s32, chunk_size);
+        }
+    }
+}
+
+void test_bulk_conversions()
+{
+    for(unsigned seed = 0; seed < 200; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        test_bulk_conversion<wchar_t>(s);
+        test_bulk_conversion<char16_t>(s);
+        // All possible alignments of the input
+        for(size_t i = 1; i < 16 && i < s.size(); i++)
+            test_bulk_conversion<char16_t>(s.substr(i));
+
+        const std::u16string s16 = create_wide_test_string<char16_t>(seed, 1 + seed % 50);
+        test_bulk_conversion_to_utf8(s16);
+        for(size_t i = 1; i < 8 && i < s16.size(); i++)
+            test_bulk_conversion_to_utf8(s16.substr(i));
+        test_bulk_conversion_to_utf8(create_wide_test_string<wchar_t>(seed, 1 + seed % 50));
+
+        test_bulk_conversion<char32_t>(s);
+        for(size_t i = 1; i < 16 && i < s.size(); i++)
+            test_bulk_conversion<char32_t>(s.substr(i));
+        // UTF-8 -> UTF-8 copies the valid parts
+        for(size_t i = 0; i < 16 && i < s.size(); i++)
+            test_bulk_conversion_to_utf8(s.substr(i));
+#ifdef __cpp_lib_char8_t
+        test_bulk_conversion<char8_t>(s);
+#endif
+        const std::u32string s32 = create_wide_test_string<char32_t>(seed, 1 + seed % 50);
+        test_bulk_conversion_to_utf8(s32);
+        for(size_t i = 1; i < 8 && i < s32.size(); i++)
+            test_bulk_conversion_to_utf8(s32.substr(i));
+
+        for(size_t i = 0; i < 8 && i < s16.size(); i++)
+            test_bulk_wide_conversion<char32_t>(s16.substr(i));
+        for(size_t i = 0; i < 8 && i < s32.size(); i++)
+            test_bulk_wide_conversion<char16_t>(s32.substr(i));
+        test_bulk_wide_conversion<wchar_t>(s16);
+        test_bulk_wide_conversion<wchar_t>(s32);
+    }
+}
+
+/// Convert the NULL terminated string s via the functions searching the terminator during the conversion
+template<typename CharOut, typename CharIn>
+void test_terminated_conversion(const std::basic_string<CharIn>& s)
+{
+    using namespace boost::nowide::utf;
+    TEST(s.find(CharIn(0)) == std::basic_string<CharIn>::npos);
+    const std::basic_string<CharOut> ref = convert_reference<CharOut>(s);
+    TEST(convert_string<CharOut>(s.c_str()) == ref);
+    std::basic_string<CharOut> appended(3, CharOut('a'));
+    TEST(convert_append(appended, s.c_str()) == std::basic_string<CharOut>(3, CharOut('a')) + ref);
+
+    std::vector<CharOut> buf(ref.size() + 2, CharOut(42));
+    TEST(convert_buffer(buf.data(), ref.size() + 1, s.c_str()) == buf.data());
+    TEST(std::basic_string<CharOut>(buf.data()) == ref);
+    TEST(buf.back() == CharOut(42));
+    TEST(convert_buffer(buf.data(), ref.size(), s.c_str()) == nullptr);
+
+    // Same result as converting the range
+    for(size_t output_size : {size_t(0), ref.size() / 2, ref.size()})
+    {
+        const convert_result expected = convert(buf.data(), output_size, s.data(), s.data() + s.size());
+        const convert_result r = convert(buf.data(), output_size, s.c_str());
+        TEST_EQ(r.consumed, expected.consumed);
+        TEST_EQ(r.written, expected.written);
+        TEST_EQ(r.required, expected.required);
+        TEST_EQ(r.replacements, expected.replacements);
+    }
+}
+
+template<typename CharIn>
+void test_terminated_conversions(const std::basic_string<CharIn>& s)
+{
+    test_terminated_conversion<char>(s);
+    test_terminated_conversion<char16_t>(s);
+    test_terminated_conversion<char32_t>(s);
+}
+
+void test_terminated_conversions()
+{
+    for(unsigned seed = 0; seed < 20; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        const std::u16string s16 = create_wide_test_string<char16_t>(seed, 1 + seed % 50);
+        const std::u32string s32 = create_wide_test_string<char32_t>(seed, 1 + seed % 50);
+        // Place sequences across the blocks searched for the terminator at once
+        for(size_t prefix = 1016; prefix < 1034; prefix++)
+        {
+            test_terminated_conversions(std::string(prefix, 'a') + s);
+            test_terminated_conversions(std::u16string(prefix, u'a') + s16);
+            test_terminated_conversions(std::u32string(prefix, U'a') + s32);
+        }
+        test_terminated_conversions(s);
+        test_terminated_conversions(s16);
+        test_terminated_conversions(s32);
+    }
+    // Incomplete sequence followed by a non-trail at each possible block boundary
+    for(size_t prefix = 1016; prefix < 1034; prefix++)
+    {
+        test_terminated_conversions(std::string(prefix, 'a') + "\xE2\x82" + std::string(prefix, 'b'));
+        test_terminated_conversions(std::string(prefix, 'a') + "\xF0\x80\x80\x80" + std::string(prefix, 'b'));
+        test_terminated_conversions(std::u16string(prefix, u'a') + char16_t(0xD800) + std::u16string(prefix, u'b'));
+    }
+}
+
+/// Offset of the first invalid sequence in s (its size if there is none) using only the code point wise decode.
+/// \a error is set to its kind or 0
+template<typename CharIn>
+size_t find_first_invalid(const std::basic_string<CharIn>& s, boost::nowide::utf::code_point& error)
+{
+    using namespace boost::nowide::utf;
+    const CharIn* const end = s.data() + s.size();
+    for(const CharIn* p = s.data(); p != end;)
+    {
+        const CharIn* const cur = p;
+        error = utf_traits<CharIn>::decode(p, end);
+        if(error == illegal || error == incomplete)
+            return static_cast<size_t>(cur - s.data());
+    }
+    error = 0;
+    return s.size();
+}
+
+/// Check that f throws a utf::conversion_error for the invalid sequence of kind \a error at \a offset
+template<typename Function>
+void test_conversion_error(Function f, size_t offset, boost::nowide::utf::code_point error)
+{
+    bool thrown = false;
+    try
+    {
+        f();
+    } catch(const boost::nowide::utf::conversion_error& err)
+    {
+        thrown = true;
+        TEST_EQ(err.offset(), offset);
+        TEST_EQ(err.error(), error);
+    }
+    TEST(thrown);
+}
+
+template<typename CharOut, typename CharIn>
+void test_error_policy(const std::basic_string<CharIn>& s)
+{
+    using namespace boost::nowide::utf;
+    const CharIn* const b = s.data();
+    const CharIn* const e = b + s.size();
+    const std::basic_string<CharOut> ref = convert_reference<CharOut>(s);
+    TEST(convert_string<CharOut>(b, e, replace) == ref);
+    TEST(convert_string<CharOut>(s.c_str(), replace) == ref);
+
+    code_point error;
+    const size_t error_pos = find_first_invalid(s, error);
+    const std::basic_string<CharIn> valid = s.substr(0, error_pos);
+    const std::basic_string<CharOut> valid_ref = convert_reference<CharOut>(valid);
+
+    // strict: Conversion stops before the first invalid sequence
+    std::vector<CharOut> buf(ref.size() + 1, CharOut(42));
+    for(const convert_result& r : {convert(buf.data(), buf.size(), b, e, strict),
+                                   convert(buf.data(), buf.size(), s.c_str(), strict)})
+    {
+        TEST_EQ(r.consumed, error_pos);
+        TEST_EQ(r.written, valid_ref.size());
+        TEST_EQ(r.required, valid_ref.size());
+        TEST_EQ(r.replacements, 0u);
+        TEST_EQ(r.error, error);
+        TEST_EQ(r.complete(), error == 0);
+        TEST(std::basic_string<CharOut>(buf.data(), r.written) == valid_ref);
+    }
+    for(const convert_result& r : {convert(static_cast<CharOut*>(nullptr), 0, b, e, strict),
+                                   convert(buf.data(), valid_ref.size() / 2, s.c_str(), strict)})
+    {
+        TEST_EQ(r.required, valid_ref.size());
+        TEST_EQ(r.error, error);
+        TEST(!r.complete() || s.empty());
+    }
+    if(error == 0)
+    {
+        TEST(convert_string<CharOut>(b, e, strict) == ref);
+        TEST(convert_string<CharOut>(s.c_str(), strict) == ref);
+        TEST(convert_buffer(buf.data(), buf.size(), b, e, strict) == buf.data());
+        TEST(std::basic_string<CharOut>(buf.data()) == ref);
+    } else
+    {
+        test_conversion_error([&]() { convert_string<CharOut>(b, e, strict); }, error_pos, error);
+        test_conversion_error([&]() { convert_string<CharOut>(s.c_str(), strict); }, error_pos, error);
+        test_conversion_error([&]() { convert_buffer(buf.data(), buf.size(), b, e, strict); }, error_pos, error);
+        test_conversion_error([&]() { convert_buffer(buf.data(), buf.size(), s.c_str(), strict); }, error_pos, error);
+        // Output is unchanged on error
+        const std::basic_string<CharOut> prefix(3, CharOut('a'));
+        std::basic_string<CharOut> appended = prefix;
+        test_conversion_error([&]() { convert_append(appended, b, e, strict); }, error_pos, error);
+        TEST(appended == prefix);
+        test_conversion_error([&]() { convert_append(appended, s.c_str(), strict); }, error_pos, error);
+        TEST(appended == prefix);
+    }
+
+    // assume_valid: Same result for valid input
+    TEST(convert_string<CharOut>(valid.data(), valid.data() + valid.size(), assume_valid) == valid_ref);
+    TEST(convert_string<CharOut>(valid.c_str(), assume_valid) == valid_ref);
+    TEST(convert_buffer(buf.data(), buf.size(), valid.c_str(), assume_valid) == buf.data());
+    TEST(std::basic_string<CharOut>(buf.data()) == valid_ref);
+    const convert_result r = convert(buf.data(), buf.size(), valid.data(), valid.data() + valid.size(), assume_valid);
+    TEST_EQ(r.written, valid_ref.size());
+    TEST(r.complete());
+}
+
+template<typename CharIn>
+void test_error_policies(const std::basic_string<CharIn>& s)
+{
+    test_error_policy<char>(s);
+    test_error_policy<char16_t>(s);
+    test_error_policy<char32_t>(s);
+}
+
+void test_error_policies()
+{
+    for(unsigned seed = 0; seed < 50; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        const std::u16string s16 = create_wide_test_string<char16_t>(seed, 1 + seed % 50);
+        const std::u32string s32 = create_wide_test_string<char32_t>(seed, 1 + seed % 50);
+        test_error_policies(s);
+        test_error_policies(s16);
+        test_error_policies(s32);
+        // Error at the end of the input or after long valid runs handled by the bulk kernels
+        test_error_policies(std::string(1030, 'a') + s);
+        test_error_policies(std::string(100, 'a') + "\xE2\x82");
+        test_error_policies(std::u16string(100, u'a') + char16_t(0xD800));
+    }
+
+    using boost::nowide::narrow;
+    using boost::nowide::widen;
+    namespace utf = boost::nowide::utf;
+    const std::string hello = "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d";
+    const std::wstring whello = L"\u05e9\u05dc\u05d5\u05dd";
+    TEST(widen(hello, utf::strict) == whello);
+    TEST(widen(hello.c_str(), utf::assume_valid) == whello);
+    TEST(widen(hello.c_str(), 6, utf::replace) == whello.substr(0, 3));
+    TEST(narrow(whello, utf::strict) == hello);
+    TEST(narrow(whello.c_str(), 2, utf::assume_valid) == hello.substr(0, 4));
+    test_conversion_error([&]() { widen(hello.c_str(), 7, utf::strict); }, 6, utf::incomplete);
+    test_conversion_error([&]() { widen(hello.substr(0, 5) + "\xFF", utf::strict); }, 4, utf::illegal);
+    test_conversion_error([&]() { narrow(whello + wchar_t(0xDC00), utf::strict); }, 4, utf::illegal);
+    wchar_t wbuf[5];
+    TEST(widen(wbuf, 5, hello.c_str(), utf::strict) == wbuf);
+    TEST(wbuf == whello);
+    TEST(widen(wbuf, 4, hello.c_str(), hello.c_str() + hello.size(), utf::assume_valid) == nullptr);
+    char buf[9];
+    TEST(narrow(buf, 9, whello.c_str(), whello.c_str() + whello.size(), utf::strict) == buf);
+    TEST(buf == hello);
+    test_conversion_error([&]() { narrow(buf, 9, L"\xDC00", utf::strict); }, 0, utf::illegal);
+}
+
+/// Check utf::strlen for all alignments and lengths up to a few blocks with units which are not zero
+/// but contain zero bytes
+template<typename Char>
+void test_strlen(const Char filler)
+{
+    const size_t max_len = 200;
+    std::vector<Char> buf(max_len + 100, filler);
+    for(size_t offset = 0; offset < 32; offset++)
+    {
+        for(size_t len = 0; len < max_len; len++)
+        {
+            Char* const s = buf.data() + offset;
+            s[len] = 0;
+            TEST_EQ(boost::nowide::utf::strlen(s), len);
+            s[len] = filler;
+        }
+    }
+}
+
+void test_strlen()
+{
+    test_strlen<char>('a');
+    test_strlen<char>('\xFF');
+    test_strlen<char16_t>(u'a');
+    test_strlen<char16_t>(char16_t(0x0100));
+    test_strlen<char16_t>(char16_t(0xFFFF));
+    test_strlen<char32_t>(U'a');
+    test_strlen<char32_t>(char32_t(0x0100));
+    test_strlen<char32_t>(char32_t(0x10000));
+    test_strlen<char32_t>(char32_t(0x1000000));
+    test_strlen<wchar_t>(L'a');
+    // Long string
+    const std::u16string long_string(100000, u'\u4E00');
+    TEST_EQ(boost::nowide::utf::strlen(long_string.c_str()), long_string.size());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+/// Place NULL terminated strings right before an inaccessible page which must not be read
+void test_terminator_at_page_end()
+{
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    void* const mem = mmap(nullptr, 2 * page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    TEST(mem != MAP_FAILED);
+    unsigned char* const guard = static_cast<unsigned char*>(mem) + page_size;
+    TEST(mprotect(guard, page_size, PROT_NONE) == 0);
+    for(size_t len = 0; len < 70; len++)
+    {
+        char* const s = reinterpret_cast<char*>(guard) - len - 1;
+        std::memset(s, 'a', len);
+        s[len] = 0;
+        TEST_EQ(boost::nowide::utf::strlen(s), len);
+        TEST(boost::nowide::utf::convert_string<wchar_t>(s) == std::wstring(len, L'a'));
+        char16_t* const s16 = reinterpret_cast<char16_t*>(guard) - len - 1;
+        std::fill_n(s16, len, u'\u00E4');
+        s16[len] = 0;
+        TEST_EQ(boost::nowide::utf::strlen(s16), len);
+        TEST(boost::nowide::utf::convert_string<char>(s16) == boost::nowide::narrow(std::u16string(len, u'\u00E4')));
+        char32_t* const s32 = reinterpret_cast<char32_t*>(guard) - len - 1;
+        std::fill_n(s32, len, U'b');
+        s32[len] = 0;
+        TEST_EQ(boost::nowide::utf::strlen(s32), len);
+        TEST(boost::nowide::utf::convert_string<char16_t>(s32) == std::u16string(len, u'b'));
+    }
+    munmap(mem, 2 * page_size);
+}
+#endif
+
+/// Decode s completely with utf_traits::decode and decode_dfa and check that the results are equal
+void compare_utf8_decoders(const unsigned char* s, size_t size)
+{
+    using utf8_traits = boost::nowide::utf::utf_traits<char>;
+    const char* const begin = reinterpret_cast<const char*>(s);
+    const char* const end = begin + size;
+    for(const char* p = begin; p != end;)
+    {
+        const char* p_dfa = p;
+        const boost::nowide::utf::code_point c = utf8_traits::decode(p, end);
+        TEST_EQ(utf8_traits::decode_dfa(p_dfa, end), c);
+        TEST(p_dfa == p);
+    }
+}
+
+void test_utf8_dfa()
+{
+    // All sequences of 2 bytes followed by up to 2 bytes from each class of trail and non-trail bytes
+    const unsigned char tails[] = {0x41, 0x80, 0x90, 0xA0, 0xBF, 0xC2, 0xFF};
+    unsigned char s[4];
+    for(unsigned b0 = 0; b0 < 256; b0++)
+    {
+        s[0] = static_cast<unsigned char>(b0);
+        compare_utf8_decoders(s, 1);
+        for(unsigned b1 = 0; b1 < 256; b1++)
+        {
+            s[1] = static_cast<unsigned char>(b1);
+            compare_utf8_decoders(s, 2);
+            for(unsigned char b2 : tails)
+            {
+                s[2] = b2;
+                compare_utf8_decoders(s, 3);
+                for(unsigned char b3 : tails)
+                {
+                    s[3] = b3;
+                    compare_utf8_decoders(s, 4);
+                }
+            }
+        }
+    }
+    for(const utf8_to_wide& t : invalid_utf8_tests)
+        compare_utf8_decoders(reinterpret_cast<const unsigned char*>(t.utf8), std::strlen(t.utf8));
+    for(unsigned seed = 0; seed < 20; seed++)
+    {
+        const std::string str = create_utf8_test_string(seed, 50);
+        compare_utf8_decoders(reinterpret_cast<const unsigned char*>(str.data()), str.size());
+    }
+}
+
+#ifdef BOOST_NOWIDE_RUNTIME_DISPATCH
+/// Get the instruction set supported by the CPU, detected independently of the library if the compiler allows it
+bool get_cpu_simd_isa(boost::nowide::detail::simd_isa& isa)
+{
+    using boost::nowide::detail::simd_isa;
+#if(defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx2"))
+        isa = simd_isa::avx512bw;
+    else if(__builtin_cpu_supports("avx2"))
+        isa = simd_isa::avx2;
+    else if(__builtin_cpu_supports("sse4.1"))
+        isa = simd_isa::sse41;
+    else if(__builtin_cpu_supports("sse2"))
+        isa = simd_isa::sse2;
+    else
+        isa = simd_isa::scalar;
+    return true;
+#else
+    (void)isa;
+    return false;
+#endif
+}
+
+void test_simd_dispatch()
+{
+    using boost::nowide::detail::simd_isa;
+    const simd_isa isa = boost::nowide::detail::runtime_simd_isa();
+    const char* const names[] = {"scalar", "sse2", "sse4.1", "avx2", "avx512bw"};
+    std::cout << "- Kernels: " << names[static_cast<int>(isa)] << std::endl;
+    TEST(boost::nowide::detail::runtime_simd_isa() == isa);
+    // The library ignores unknown values of BOOST_NOWIDE_FORCE_ISA, so check that the test variants only use known ones
+    // except for the variant testing exactly that, which sets it to "invalid"
+    simd_isa requested = simd_isa::avx512bw;
+    const char* forced = std::getenv("BOOST_NOWIDE_FORCE_ISA");
+    if(forced && *forced && std::string(forced) != "invalid")
+    {
+        bool known = false;
+        for(int i = 0; i <= static_cast<int>(simd_isa::avx512bw); i++)
+        {
+            if(std::string(forced) == names[i] || (i == 2 && std::string(forced) == "sse41"))
+            {
+                requested = static_cast<simd_isa>(i);
+                known = true;
+            }
+        }
+        TEST(known);
+    }
+    simd_isa cpu_isa;
+    if(get_cpu_simd_isa(cpu_isa))
+        TEST(isa == (std::min)(requested, cpu_isa));
+    else
+        TEST(isa <= requested);
+}
+#endif
+
+/// Return the number of input code units the bulk kernels consumed while converting s to CharOut and counting its
+/// output length
+template<typename CharOut, typename CharIn>
+std::size_t bulk_consumed_units(const std::basic_string<CharIn>& s, bool count_only)
+{
+    using boost::nowide::detail::bulk_consumed_units;
+    bulk_consumed_units() = 0;
+    if(count_only)
+        TEST(boost::nowide::utf::output_length<CharOut>(s.data(), s.data() + s.size()) > 0u);
+    else
+        TEST(!boost::nowide::utf::convert_string<CharOut>(s.data(), s.data() + s.size()).empty());
+    return bulk_consumed_units();
+}
+
+void test_kernels_used()
+{
+    using boost::nowide::detail::simd_isa;
+#ifdef BOOST_NOWIDE_RUNTIME_DISPATCH
+    const simd_isa isa = boost::nowide::detail::runtime_simd_isa();
+#else
+    const simd_isa isa = boost::nowide::detail::compiled_simd_isa;
+#endif
+    (void)isa;
+    const std::string utf8(1000, 'a');
+    const std::u16string utf16(1000, u'a');
+    const std::u32string utf32(1000, U'a');
+    // Each direction with the minimum instruction set of its kernels
+#if defined(BOOST_NOWIDE_SIMD_SSE2) || defined(BOOST_NOWIDE_SWAR)
+    TEST(bulk_consumed_units<char16_t>(utf8, false) > 0u);
+    TEST(bulk_consumed_units<char32_t>(utf8, false) > 0u);
+    TEST(bulk_consumed_units<char>(utf16, false) > 0u);
+    TEST(bulk_consumed_units<char>(utf32, false) > 0u);
+    TEST(bulk_consumed_units<char>(utf16, true) > 0u);
+    TEST(bulk_consumed_units<char>(utf32, true) > 0u);
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE2
+    if(isa >= simd_isa::sse2)
+    {
+        TEST(bulk_consumed_units<char32_t>(utf16, false) > 0u);
+        TEST(bulk_consumed_units<char16_t>(utf32, false) > 0u);
+        TEST(bulk_consumed_units<char32_t>(utf16, true) > 0u);
+        TEST(bulk_consumed_units<char16_t>(utf32, true) > 0u);
+    }
+#endif
+#ifdef BOOST_NOWIDE_SIMD_SSE41
+    if(isa >= simd_isa::sse41)
+    {
+        TEST(bulk_consumed_units<char16_t>(utf8, true) > 0u);
+        TEST(bulk_consumed_units<char32_t>(utf8, true) > 0u);
+    }
+#endif
+}
+
 // coverity [root_function]
 void test_main(int, char**, char**)
 {
@@ -171,6 +898,64 @@ void test_main(int, char**, char**)
         TEST(boost::nowide::narrow(L"\u05e9\u05dc\u05d5\u05dd") == hello);
     }
 
+    std::cout << "- boost::nowide::to_u16string/to_u32string" << std::endl;
+    {
+        const std::u16string u16 = u"\u05e9\u05dc\U0001033C\u05d5\u05dd";
+        const std::u32string u32 = U"\u05e9\u05dc\U0001033C\u05d5\u05dd";
+        const std::string utf8 = boost::nowide::narrow(u32);
+        TEST(boost::nowide::to_u16string(utf8) == u16);
+        TEST(boost::nowide::to_u16string(u32) == u16);
+        TEST(boost::nowide::to_u16string(u32.c_str()) == u16);
+        TEST(boost::nowide::to_u16string(u16) == u16);
+        TEST(boost::nowide::to_u32string(utf8.c_str()) == u32);
+        TEST(boost::nowide::to_u32string(u16) == u32);
+        TEST(boost::nowide::to_u32string(u16.c_str(), 4) == u32.substr(0, 3));
+        TEST(boost::nowide::to_u32string(u32) == u32);
+        TEST(boost::nowide::to_u16string(whello) == boost::nowide::to_u16string(hello));
+        TEST(boost::nowide::to_u32string(whello) == boost::nowide::to_u32string(hello));
+        // Split or lone surrogates and invalid code points are replaced
+        TEST(boost::nowide::to_u32string(u16.c_str(), 3) == U"\u05e9\u05dc\ufffd");
+        TEST(boost::nowide::to_u32string(u16.substr(3)) == U"\ufffd\u05d5\u05dd");
+        TEST(boost::nowide::to_u16string(std::u32string(1, char32_t(0x110000))) == u"\ufffd");
+        TEST(boost::nowide::to_u16string(std::u32string(1, char32_t(0xD800))) == u"\ufffd");
+    }
+
+#ifdef __cpp_lib_char8_t
+    std::cout << "- char8_t and std::u8string" << std::endl;
+    {
+        const std::u8string u8 = u8"\u05e9\u05dc\U0001033C\u05d5\u05dd";
+        const std::wstring wide = L"\u05e9\u05dc\U0001033C\u05d5\u05dd";
+        TEST(boost::nowide::widen(u8) == wide);
+        TEST(boost::nowide::widen(u8.c_str()) == wide);
+        TEST(boost::nowide::widen(u8.data(), 2) == L"\u05e9");
+        TEST(boost::nowide::to_u8string(wide) == u8);
+        TEST(boost::nowide::to_u8string(wide.c_str()) == u8);
+        TEST(boost::nowide::to_u8string(boost::nowide::to_u16string(u8)) == u8);
+        TEST(boost::nowide::to_u8string(boost::nowide::narrow(wide)) == u8);
+        TEST(boost::nowide::to_u8string(u8) == u8);
+        // Invalid sequences are replaced in conversions between char and char8_t too
+        TEST(boost::nowide::to_u8string(std::string("a\xff" "b\xe0\x80")) == u8"a\ufffd" "b\ufffd");
+        const std::u8string invalid_u8 = u8"\u05e9\xc3";
+        TEST(boost::nowide::utf::convert_string<char>(invalid_u8.data(), invalid_u8.data() + invalid_u8.size())
+             == "\xd7\xa9\xef\xbf\xbd");
+        wchar_t buf[16];
+        TEST(boost::nowide::utf::convert_buffer(buf, 16, u8.c_str()) == buf);
+        TEST(buf == wide);
+    }
+#endif
+
+#ifndef BOOST_NO_CXX14_CONSTEXPR
+    std::cout << "- boost::nowide::utf::convert_literal" << std::endl;
+    {
+        TEST(literal_wide.str() == whello);
+        TEST(std::wstring(literal_wide.begin(), literal_wide.end()) == whello);
+        TEST(literal_utf8.c_str() == boost::nowide::narrow(u"\u05e9\U0001033C"));
+        // Also usable at runtime
+        const auto literal = boost::nowide::utf::convert_literal<char>(L"\u05e9\u05dc\u05d5\u05dd");
+        TEST(literal.str() == hello);
+    }
+#endif
+
     std::cout << "- boost::nowide::utf::convert_buffer" << std::endl;
     {
         std::array<wchar_t, 6> buf;
@@ -187,6 +972,16 @@ void test_main(int, char**, char**)
         TEST(std::wstring(buf.data()) == whello);
     }
 
+    std::cout << "- boost::nowide::utf::convert_string" << std::endl;
+    {
+        // Each replaced byte becomes the 3 byte replacement character, so UTF-8 -> UTF-8 may grow
+        const std::string invalid = "a\xff\xfe" "b";
+        const std::string converted =
+          boost::nowide::utf::convert_string<char>(invalid.data(), invalid.data() + invalid.size());
+        TEST_EQ(converted.size(), 8u);
+        TEST(converted == "a\xef\xbf\xbd\xef\xbf\xbd" "b");
+    }
+
     std::cout << "- (output_buffer, buffer_size, input_raw_string)" << std::endl;
     run_all(widen_buf_ptr, narrow_buf_ptr);
     std::cout << "- (output_buffer, buffer_size, input_raw_string, string_len)" << std::endl;
@@ -203,4 +998,30 @@ void test_main(int, char**, char**)
 #endif
     std::cout << "- (utf::convert_buffer)" << std::endl;
     run_all(widen_convert_buffer, narrow_convert_buffer);
+    std::cout << "- (output_string, input)" << std::endl;
+    run_all(widen_into, narrow_into);
+    std::cout << "- (output_string, input) append" << std::endl;
+    run_all(widen_append, narrow_append);
+    test_convert_into();
+
+#ifdef BOOST_NOWIDE_RUNTIME_DISPATCH
+    test_simd_dispatch();
+#endif
+    std::cout << "- Bulk kernels are used" << std::endl;
+    test_kernels_used();
+    std::cout << "- UTF-8 DFA decoder" << std::endl;
+    test_utf8_dfa();
+    std::cout << "- Bulk conversion of long strings" << std::endl;
+    test_bulk_conversions();
+    std::cout << "- utf::convert" << std::endl;
+    test_convert_result();
+    std::cout << "- utf::strlen" << std::endl;
+    test_strlen();
+    std::cout << "- NULL terminated input" << std::endl;
+    test_terminated_conversions();
+    std::cout << "- Error policies" << std::endl;
+    test_error_policies();
+#if defined(__unix__) || defined(__APPLE__)
+    test_terminator_at_page_end();
+#endif
 }
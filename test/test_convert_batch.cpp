@@ -0,0 +1,144 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/nowide/utf/convert_batch.hpp>
+#include "test.hpp"
+#include "test_sets.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using boost::nowide::utf::convert_batch;
+using boost::nowide::utf::string_arena;
+
+/// Check that \a arena holds the conversion of each of the \a strings, stored back-to-back
+template<typename CharOut, typename CharIn>
+void check_arena(const string_arena<CharOut>& arena, const std::vector<std::basic_string<CharIn>>& strings)
+{
+    TEST_EQ(arena.size(), strings.size());
+    TEST_EQ(arena.empty(), strings.empty());
+    std::basic_string<CharOut> expected_buffer;
+    for(size_t i = 0; i < strings.size(); i++)
+    {
+        const std::basic_string<CharOut> ref = convert_reference<CharOut>(strings[i]);
+        TEST_EQ(arena.offset(i), expected_buffer.size());
+        TEST_EQ(arena.length(i), ref.size());
+        TEST(arena.str(i) == ref);
+        TEST(std::basic_string<CharOut>(arena[i]) == ref.substr(0, ref.find(CharOut(0))));
+        TEST(arena.c_str(i)[ref.size()] == 0);
+        expected_buffer += ref;
+        expected_buffer += CharOut(0);
+    }
+    TEST(arena.buffer() == expected_buffer);
+}
+
+template<typename CharOut, typename CharIn>
+void test_batch(const std::vector<std::basic_string<CharIn>>& strings)
+{
+    check_arena(convert_batch<CharOut>(strings.begin(), strings.end()), strings);
+    // NULL terminated input
+    std::vector<const CharIn*> c_strings;
+    std::vector<std::basic_string<CharIn>> terminated;
+    for(const std::basic_string<CharIn>& s : strings)
+    {
+        c_strings.push_back(s.c_str());
+        terminated.push_back(s.substr(0, s.find(CharIn(0))));
+    }
+    check_arena(convert_batch<CharOut>(c_strings.begin(), c_strings.end()), terminated);
+    // Reuse an arena with existing content
+    string_arena<CharOut> arena = convert_batch<CharOut>(strings.rbegin(), strings.rend());
+    arena.assign(strings.begin(), strings.end());
+    check_arena(arena, strings);
+    arena.clear();
+    check_arena(arena, std::vector<std::basic_string<CharIn>>());
+}
+
+void test_simple()
+{
+    const std::vector<std::string> empty;
+    test_batch<wchar_t>(empty);
+    test_batch<char16_t>(std::vector<std::string>(3));
+
+    const std::vector<std::string> files = {"a.txt", "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d.txt", "", "\xf0\x9d\x92\x9e",
+                                            "invalid\xff" "end", std::string("emb\0edded", 9), "incomplete\xe2\x82"};
+    test_batch<wchar_t>(files);
+    test_batch<char16_t>(files);
+    test_batch<char32_t>(files);
+    test_batch<char>(files);
+
+    const std::vector<std::u16string> files16 = {u"a.txt", u"\u05e9\u05dc\u05d5\u05dd.txt", u"", u"\U0001D49E",
+                                                 u"lone\xD800surrogate"};
+    test_batch<char>(files16);
+    test_batch<char32_t>(files16);
+
+    // Array of NULL terminated strings, e.g. argv
+    const char* const argv[] = {"prog", "--name=\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d"};
+    const string_arena<wchar_t> args = convert_batch<wchar_t>(argv, argv + 2);
+    TEST_EQ(args.size(), 2u);
+    TEST(args.str(0) == L"prog");
+    TEST(args.str(1) == L"--name=\u05e9\u05dc\u05d5\u05dd");
+}
+
+void test_strict()
+{
+    using boost::nowide::utf::conversion_error;
+    using boost::nowide::utf::strict;
+    const std::vector<std::string> valid = {"a", "\xd7\xa9", "\xf0\x9d\x92\x9e"};
+    check_arena(convert_batch<wchar_t>(valid.begin(), valid.end(), strict), valid);
+
+    const std::vector<std::string> strings = {"a", "\xd7\xa9", "ab\xff", "c"};
+    string_arena<wchar_t> arena;
+    try
+    {
+        arena.assign(strings.begin(), strings.end(), strict);
+        TEST(false); // LCOV_EXCL_LINE
+    } catch(const conversion_error& e)
+    {
+        TEST_EQ(e.offset(), 2u);
+        TEST_EQ(e.error(), boost::nowide::utf::illegal);
+    }
+    // Strings before the invalid one are kept
+    check_arena(arena, std::vector<std::string>(strings.begin(), strings.begin() + 2));
+
+    const std::vector<std::u16string> strings16 = {u"a", u"b\xDC00"};
+    try
+    {
+        convert_batch<char>(strings16.begin(), strings16.end(), strict);
+        TEST(false); // LCOV_EXCL_LINE
+    } catch(const conversion_error& e)
+    {
+        TEST_EQ(e.offset(), 1u);
+    }
+}
+
+void test_long_strings()
+{
+    std::vector<std::string> strings;
+    std::vector<std::u16string> strings16;
+    for(unsigned seed = 0; seed < 50; seed++)
+    {
+        strings.push_back(create_utf8_test_string(seed, 1 + seed % 20));
+        strings16.push_back(create_wide_test_string<char16_t>(seed, 1 + seed % 20));
+    }
+    test_batch<wchar_t>(strings);
+    test_batch<char16_t>(strings);
+    test_batch<char32_t>(strings);
+    test_batch<char>(strings16);
+    test_batch<char32_t>(strings16);
+}
+
+// coverity [root_function]
+void test_main(int, char**, char**)
+{
+    std::cout << "- Simple cases" << std::endl;
+    test_simple();
+    std::cout << "- Strict error policy" << std::endl;
+    test_strict();
+    std::cout << "- Long strings" << std::endl;
+    test_long_strings();
+}
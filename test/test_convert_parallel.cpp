@@ -0,0 +1,185 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/nowide/utf/convert_parallel.hpp>
+#include "test.hpp"
+#include "test_sets.hpp"
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Executor starting a thread per task, joined on destruction
+class thread_executor
+{
+    std::vector<std::thread> threads_;
+
+public:
+    void operator()(std::function<void()> task)
+    {
+        threads_.emplace_back(std::move(task));
+    }
+    size_t num_tasks() const
+    {
+        return threads_.size();
+    }
+    ~thread_executor()
+    {
+        for(std::thread& t : threads_)
+            t.join();
+    }
+};
+
+/// Check that every position detected as a boundary is one where the sequential decode starts a code point
+template<typename CharIn>
+void test_boundaries(const std::basic_string<CharIn>& s)
+{
+    using boost::nowide::detail::is_code_point_boundary;
+    std::vector<bool> is_boundary(s.size() + 1, false);
+    const CharIn* const begin = s.data();
+    const CharIn* const end = begin + s.size();
+    for(const CharIn* p = begin; p != end;)
+    {
+        is_boundary[p - begin] = true;
+        boost::nowide::utf::utf_traits<CharIn>::decode(p, end);
+    }
+    is_boundary[s.size()] = true;
+    for(size_t i = 0; i <= s.size(); i++)
+    {
+        if(is_code_point_boundary(begin, begin + i))
+            TEST(is_boundary[i]);
+    }
+}
+
+template<typename CharOut, typename CharIn>
+void test_parallel(const std::basic_string<CharIn>& s)
+{
+    using boost::nowide::utf::convert_string_parallel;
+    const CharIn* const begin = s.data();
+    const CharIn* const end = begin + s.size();
+    const std::basic_string<CharOut> ref = boost::nowide::utf::convert_string<CharOut>(begin, end);
+    TEST(ref == convert_reference<CharOut>(s));
+    for(size_t num_chunks : {0, 1, 2, 3, 7, 16, 100})
+    {
+        // Executor running the tasks immediately
+        size_t num_tasks = 0;
+        auto inline_executor = [&num_tasks](std::function<void()> task) {
+            ++num_tasks;
+            task();
+        };
+        TEST(convert_string_parallel<CharOut>(begin, end, inline_executor, num_chunks) == ref);
+        if(num_chunks > 1)
+            TEST_EQ(num_tasks, 2 * (num_chunks - 1)); // 2 phases with one chunk done by the calling thread
+        thread_executor executor;
+        TEST(convert_string_parallel<CharOut>(begin, end, executor, num_chunks) == ref);
+    }
+    TEST(convert_string_parallel<CharOut>(begin, end) == ref);
+    TEST(convert_string_parallel<CharOut>(begin, end, 3) == ref);
+}
+
+/// Executor starting a thread per task like thread_executor except that its Nth call throws, e.g. for a full pool
+class failing_executor : public thread_executor
+{
+    size_t calls_left_;
+
+public:
+    explicit failing_executor(size_t fail_at) : calls_left_(fail_at)
+    {}
+    void operator()(std::function<void()> task)
+    {
+        if(calls_left_ != 0 && --calls_left_ == 0)
+            throw std::runtime_error("Executor full");
+        thread_executor::operator()(std::move(task));
+    }
+};
+
+template<typename CharOut, typename CharIn>
+void test_failing_executor(const std::basic_string<CharIn>& s)
+{
+    using boost::nowide::utf::convert_string_parallel;
+    const CharIn* const begin = s.data();
+    const CharIn* const end = begin + s.size();
+    const std::basic_string<CharOut> ref = boost::nowide::utf::convert_string<CharOut>(begin, end);
+    // 2 phases with 7 tasks each, the remaining tasks are run by the calling thread
+    for(size_t fail_at = 1; fail_at <= 14; fail_at++)
+    {
+        failing_executor executor(fail_at);
+        TEST(convert_string_parallel<CharOut>(begin, end, executor, 8) == ref);
+        TEST_EQ(executor.num_tasks(), (fail_at <= 7) ? fail_at - 1 + 7 : fail_at - 1);
+    }
+}
+
+void test_simple()
+{
+    using boost::nowide::utf::convert_string_parallel;
+    const std::string empty;
+    thread_executor executor;
+    TEST(convert_string_parallel<wchar_t>(empty.data(), empty.data(), executor, 4).empty());
+    TEST(convert_string_parallel<char16_t>(empty.data(), empty.data(), 4).empty());
+
+    // Splitting an invalid sequence changes the result, e.g. "\xe2" and "a" would be 2 code points
+    const std::string s = "\xe2" "a\xf0\x90\x8c\xbc\xf0\x90\x8c" "b";
+    test_boundaries(s);
+    using boost::nowide::detail::is_code_point_boundary;
+    TEST(!is_code_point_boundary(s.data(), s.data() + 1));
+    TEST(is_code_point_boundary(s.data(), s.data() + 2));
+    TEST(!is_code_point_boundary(s.data(), s.data() + 3));
+    TEST(is_code_point_boundary(s.data(), s.data() + 6));
+    TEST(!is_code_point_boundary(s.data(), s.data() + 9));
+    test_parallel<char16_t>(s);
+
+    const std::u16string s16 = u"a\xD800" "b\xDC00\xD800\xDC00";
+    TEST(!is_code_point_boundary(s16.data(), s16.data() + 2));
+    TEST(is_code_point_boundary(s16.data(), s16.data() + 4));
+    TEST(!is_code_point_boundary(s16.data(), s16.data() + 5));
+    test_boundaries(s16);
+    test_parallel<char>(s16);
+}
+
+void test_executor_failure()
+{
+    const std::string s = create_utf8_test_string(42, 200);
+    test_failing_executor<char16_t>(s);
+    test_failing_executor<char>(create_wide_test_string<char32_t>(42, 200));
+}
+
+void test_long_strings()
+{
+    for(unsigned seed = 0; seed < 50; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        test_boundaries(s);
+        test_parallel<wchar_t>(s);
+        test_parallel<char16_t>(s);
+        test_parallel<char32_t>(s);
+        const std::u16string s16 = create_wide_test_string<char16_t>(seed, 1 + seed % 50);
+        test_boundaries(s16);
+        test_parallel<char>(s16);
+        test_parallel<char>(create_wide_test_string<char32_t>(seed, 1 + seed % 50));
+    }
+    // Large enough to be split when using the number of threads
+    std::string s;
+    for(unsigned seed = 0; s.size() < 4 * boost::nowide::detail::min_parallel_chunk_size; seed++)
+        s += create_utf8_test_string(seed, 50);
+    test_parallel<char16_t>(s);
+    const std::wstring ws = boost::nowide::utf::convert_string<wchar_t>(s.data(), s.data() + s.size());
+    test_parallel<char>(ws);
+}
+
+// coverity [root_function]
+void test_main(int, char**, char**)
+{
+    std::cout << "- Simple cases" << std::endl;
+    test_simple();
+    std::cout << "- Failing executor" << std::endl;
+    test_executor_failure();
+    std::cout << "- Long strings" << std::endl;
+    test_long_strings();
+}
@@ -9,7 +9,10 @@
 #define BOOST_NOWIDE_TEST_SETS_HPP_INCLUDED
 
 #include <boost/nowide/config.hpp>
+#include <boost/nowide/utf/utf.hpp>
 #include <iostream>
+#include <iterator>
+#include <random>
 #include <string>
 
 struct utf8_to_wide
@@ -111,6 +114,132 @@ const wide_to_utf8 invalid_utf32_tests[] = {
 
 // clang-format on
 
+/// Convert using only the code point wise decode & encode of the utf_traits
+/// to get a reference result for the optimized conversion functions
+template<typename CharOut, typename CharIn>
+std::basic_string<CharOut> convert_reference(const std::basic_string<CharIn>& s)
+{
+    using namespace boost::nowide::utf;
+    std::basic_string<CharOut> result;
+    const CharIn* begin = s.data();
+    const CharIn* const end = begin + s.size();
+    while(begin != end)
+    {
+        code_point c = utf_traits<CharIn>::decode(begin, end);
+        if(c == illegal || c == incomplete)
+            c = BOOST_NOWIDE_REPLACEMENT_CHARACTER;
+        utf_traits<CharOut>::encode(c, std::back_inserter(result));
+    }
+    return result;
+}
+
+/// Create a long UTF-8 string consisting of runs of characters of the same width
+/// interleaved with invalid sequences.
+/// Same seed produces the same string
+inline std::string create_utf8_test_string(unsigned seed, size_t num_runs)
+{
+    std::minstd_rand rng(seed + 1);
+    std::string result;
+    const auto rand_between = [&rng](unsigned min, unsigned max) { return min + rng() % (max - min + 1); };
+    const auto append = [&result](boost::nowide::utf::code_point c) {
+        boost::nowide::utf::utf_traits<char>::encode(c, std::back_inserter(result));
+    };
+    for(size_t i = 0; i < num_runs; i++)
+    {
+        const unsigned run_length = rand_between(1, 40);
+        switch(rand_between(0, 7))
+        {
+        case 0:
+        case 1:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0x01, 0x7F));
+            break;
+        case 2:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0x80, 0x7FF));
+            break;
+        case 3:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0x800, 0xD7FF));
+            break;
+        case 4:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0xE000, 0xFFFF));
+            break;
+        case 5:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0x10000, 0x10FFFF));
+            break;
+        case 6:
+            // Random (likely invalid) bytes
+            for(unsigned j = 0; j < run_length % 5; j++)
+                result += static_cast<char>(rand_between(0x80, 0xFF));
+            break;
+        default:
+        {
+            // Sequences which are structurally correct but invalid: Overlong, surrogate, too large
+            static const char* const invalid[] = {"\xC0\x80", "\xE0\x9F\xBF", "\xED\xA0\x80", "\xF4\x90\x80\x80"};
+            result += invalid[rand_between(0, 3)];
+            // Truncated sequence
+            std::string tmp;
+            boost::nowide::utf::utf_traits<char>::encode(rand_between(0x80, 0x10FFFF), std::back_inserter(tmp));
+            if(tmp.size() > 1 && rand_between(0, 1))
+                tmp.pop_back();
+            result += tmp;
+        }
+        }
+    }
+    return result;
+}
+
+/// Create a long UTF-16 or UTF-32 string consisting of runs of code points with the same UTF-8 width
+/// interleaved with invalid code units (lone surrogates, too large values).
+/// Same seed produces the same string
+template<typename CharType>
+std::basic_string<CharType> create_wide_test_string(unsigned seed, size_t num_runs)
+{
+    std::minstd_rand rng(seed + 1);
+    std::basic_string<CharType> result;
+    const auto rand_between = [&rng](unsigned min, unsigned max) { return min + rng() % (max - min + 1); };
+    const auto append = [&result](boost::nowide::utf::code_point c) {
+        boost::nowide::utf::utf_traits<CharType>::encode(c, std::back_inserter(result));
+    };
+    for(size_t i = 0; i < num_runs; i++)
+    {
+        const unsigned run_length = rand_between(1, 40);
+        switch(rand_between(0, 6))
+        {
+        case 0:
+        case 1:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0x01, 0x7F));
+            break;
+        case 2:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0x80, 0x7FF));
+            break;
+        case 3:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0x800, 0xD7FF));
+            break;
+        case 4:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0xE000, 0xFFFF));
+            break;
+        case 5:
+            for(unsigned j = 0; j < run_length; j++)
+                append(rand_between(0x10000, 0x10FFFF));
+            break;
+        default:
+            // Lone high or low surrogate
+            result += static_cast<CharType>(rand_between(0xD800, 0xDFFF));
+            if(sizeof(CharType) == 4 && rand_between(0, 1))
+                result += static_cast<CharType>(rand_between(0x110000, 0xFFFFFFFF));
+        }
+    }
+    return result;
+}
+
 #ifdef BOOST_MSVC
 #pragma warning(push)
 #pragma warning(disable : 4127) // Constant expression detected
@@ -129,6 +129,17 @@ void test_main(int, char**, char**)
         TEST(sw.uses_stack_memory());
         TEST(sw.get() == whello);
     }
+    {
+        std::cout << "-- Will be put on stack if the output fits exactly" << std::endl;
+        test_basic_stackstring<wchar_t, char, 5> sw;
+        TEST(sw.convert(hello.c_str()));
+        TEST(sw.uses_stack_memory());
+        TEST(sw.get() == whello);
+        test_basic_stackstring<wchar_t, char, 4> sw2;
+        TEST(sw2.convert(hello.c_str()));
+        TEST(sw2.uses_heap_memory());
+        TEST(sw2.get() == whello);
+    }
     {
         std::cout << "-- Will be put on heap" << std::endl;
         test_basic_stackstring<char, wchar_t, 3> sw;
@@ -240,8 +251,32 @@ void test_main(int, char**, char**)
         TEST(strings[1].get() == std::wstring(L"Hello World"));
         TEST(strings[2].get() == std::wstring(L"FooBar"));
     }
+#ifdef __cpp_lib_char8_t
+    {
+        std::cout << "-- char8_t input and output" << std::endl;
+        const char8_t* u8 = u8"\u05e9\u05dc\u05d5\u05dd";
+        const boost::nowide::basic_stackstring<wchar_t, char8_t> ws(u8);
+        TEST(ws.get() == whello);
+        const boost::nowide::basic_stackstring<wchar_t, char8_t, 3> heap_ws(u8, u8 + 4);
+        TEST(heap_ws.get() == whello.substr(0, 2));
+        const boost::nowide::u8stackstring ns(whello.c_str());
+        TEST(std::u8string(ns.get()) == u8);
+        const boost::nowide::u8short_stackstring short_ns(whello.c_str());
+        TEST(std::u8string(short_ns.get()) == u8);
+    }
+#endif
     std::cout << "- Stackstring" << std::endl;
     run_all(stackstring_to_wide, stackstring_to_narrow);
     std::cout << "- Heap Stackstring" << std::endl;
     run_all(heap_stackstring_to_wide, heap_stackstring_to_narrow);
+    std::cout << "- Long strings" << std::endl;
+    for(unsigned seed = 0; seed < 20; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 100);
+        const boost::nowide::wstackstring ws(s.c_str());
+        TEST(ws.get() == boost::nowide::widen(s));
+        const std::wstring w = boost::nowide::widen(s);
+        const boost::nowide::stackstring ns(w.c_str());
+        TEST(ns.get() == boost::nowide::narrow(w));
+    }
 }
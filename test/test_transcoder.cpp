@@ -0,0 +1,156 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/nowide/utf/transcoder.hpp>
+#include <boost/nowide/utf/convert.hpp>
+#include "test.hpp"
+#include "test_sets.hpp"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using boost::nowide::utf::transcode_result;
+using boost::nowide::utf::transcoder;
+
+/// Feed s in chunks of random size (up to max_chunk_size) to a transcoder writing to
+/// output buffers of random size (up to max_output_size) and return the concatenated output
+template<typename CharOut, typename CharIn>
+std::basic_string<CharOut>
+transcode_chunked(const std::basic_string<CharIn>& s, unsigned seed, size_t max_chunk_size, size_t max_output_size)
+{
+    std::minstd_rand rng(seed + 1);
+    transcoder<CharIn, CharOut> conv;
+    std::basic_string<CharOut> result;
+    std::vector<CharOut> buf(max_output_size + 1);
+    size_t pos = 0;
+    while(pos < s.size())
+    {
+        const size_t chunk_size = std::min<size_t>(1 + rng() % max_chunk_size, s.size() - pos);
+        const CharIn* begin = s.data() + pos;
+        const CharIn* const end = begin + chunk_size;
+        // Feed the chunk until all of it is consumed, possibly using multiple output buffers
+        do
+        {
+            const size_t output_size = 4 + rng() % (max_output_size - 3);
+            buf[output_size] = CharOut(42);
+            const transcode_result r = conv.feed(begin, end, buf.data(), output_size);
+            TEST(r.written <= output_size);
+            TEST(buf[output_size] == CharOut(42));
+            result.append(buf.data(), r.written);
+            begin += r.consumed;
+            TEST(conv.pending() < static_cast<size_t>(boost::nowide::utf::utf_traits<CharIn>::max_width));
+        } while(begin != end);
+        pos += chunk_size;
+    }
+    const transcode_result r = conv.finish(buf.data(), buf.size());
+    TEST_EQ(r.consumed, 0u);
+    TEST_EQ(r.replacements, r.written ? 1u : 0u);
+    TEST_EQ(conv.pending(), 0u);
+    result.append(buf.data(), r.written);
+    return result;
+}
+
+template<typename CharOut, typename CharIn>
+void test_chunked(const std::basic_string<CharIn>& s, unsigned seed)
+{
+    const std::basic_string<CharOut> ref = convert_reference<CharOut>(s);
+    TEST(transcode_chunked<CharOut>(s, seed, 1, 4) == ref);
+    TEST(transcode_chunked<CharOut>(s, seed, 5, 10) == ref);
+    TEST(transcode_chunked<CharOut>(s, seed, 100, 8) == ref);
+    TEST(transcode_chunked<CharOut>(s, seed, 200, 300) == ref);
+}
+
+void test_split_sequences()
+{
+    // Every split position of valid and invalid sequences, fed byte by byte
+    for(const utf8_to_wide& t : invalid_utf8_tests)
+    {
+        const std::string s = std::string("ab") + t.utf8 + "\xe2\x82\xa1";
+        TEST(transcode_chunked<wchar_t>(s, 0, 1, 4) == convert_reference<wchar_t>(s));
+        TEST(transcode_chunked<char16_t>(s, 0, 1, 4) == convert_reference<char16_t>(s));
+    }
+    {
+        transcoder<char, wchar_t> conv;
+        wchar_t buf[8];
+        const std::string s = "\xf0\x90\x8c\xbc";
+        transcode_result r = conv.feed(s.data(), s.data() + 3, buf, 8);
+        TEST_EQ(r.consumed, 3u);
+        TEST_EQ(r.written, 0u);
+        TEST_EQ(conv.pending(), 3u);
+        // Output too small for the completed code point: Nothing is consumed
+        r = conv.feed(s.data() + 3, s.data() + 4, buf, 0);
+        TEST_EQ(r.consumed, 0u);
+        TEST_EQ(r.written, 0u);
+        TEST_EQ(conv.pending(), 3u);
+        r = conv.feed(s.data() + 3, s.data() + 4, buf, 8);
+        TEST_EQ(r.consumed, 1u);
+        TEST(std::wstring(buf, r.written) == boost::nowide::utf::convert_string<wchar_t>(s.data(), s.data() + 4));
+        TEST_EQ(conv.pending(), 0u);
+        TEST_EQ(conv.finish(buf, 8).written, 0u);
+    }
+    {
+        // Incomplete sequence at the end of the input
+        transcoder<char, char16_t> conv;
+        char16_t buf[8];
+        const std::string s = "a\xe2\x82";
+        transcode_result r = conv.feed(s.data(), s.data() + s.size(), buf, 8);
+        TEST_EQ(r.consumed, 3u);
+        TEST_EQ(r.written, 1u);
+        TEST_EQ(conv.pending(), 2u);
+        r = conv.finish(buf, 0);
+        TEST_EQ(r.written, 0u);
+        TEST_EQ(conv.pending(), 2u);
+        r = conv.finish(buf, 8);
+        TEST_EQ(r.written, 1u);
+        TEST_EQ(r.replacements, 1u);
+        TEST(buf[0] == char16_t(BOOST_NOWIDE_REPLACEMENT_CHARACTER));
+        TEST_EQ(conv.pending(), 0u);
+        // Reset discards the pending input
+        conv.feed(s.data(), s.data() + s.size(), buf, 8);
+        conv.reset();
+        TEST_EQ(conv.pending(), 0u);
+        TEST_EQ(conv.finish(buf, 8).written, 0u);
+    }
+    {
+        // High surrogate at the end of a chunk
+        transcoder<char16_t, char> conv;
+        char buf[8];
+        const std::u16string s = u"\U0001033C";
+        transcode_result r = conv.feed(s.data(), s.data() + 1, buf, 8);
+        TEST_EQ(r.consumed, 1u);
+        TEST_EQ(conv.pending(), 1u);
+        r = conv.feed(s.data() + 1, s.data() + 2, buf, 8);
+        TEST_EQ(r.written, 4u);
+        TEST(std::string(buf, 4) == "\xf0\x90\x8c\xbc");
+    }
+}
+
+void test_long_strings()
+{
+    for(unsigned seed = 0; seed < 100; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        test_chunked<wchar_t>(s, seed);
+        test_chunked<char16_t>(s, seed);
+        test_chunked<char32_t>(s, seed);
+        test_chunked<char>(create_wide_test_string<char16_t>(seed, 1 + seed % 50), seed);
+        test_chunked<char>(create_wide_test_string<char32_t>(seed, 1 + seed % 50), seed);
+        test_chunked<char>(create_wide_test_string<wchar_t>(seed, 1 + seed % 50), seed);
+    }
+}
+
+// coverity [root_function]
+void test_main(int, char**, char**)
+{
+    std::cout << "- Split sequences" << std::endl;
+    test_split_sequences();
+    std::cout << "- Long strings in chunks" << std::endl;
+    test_long_strings();
+}
@@ -0,0 +1,296 @@
+//
+//  Copyright (c) 2021 Alexander Grund
+//
+//  Distributed under the Boost Software License, Version 1.0. (See
+//  accompanying file LICENSE or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/nowide/utf/validate.hpp>
+#include "test.hpp"
+#include "test_sets.hpp"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using boost::nowide::utf::validation_result;
+
+/// Validate using only the code point wise decode of the utf_traits
+template<typename CharIn>
+validation_result validate_reference(const std::basic_string<CharIn>& s)
+{
+    using namespace boost::nowide::utf;
+    const CharIn* p = s.data();
+    const CharIn* const end = p + s.size();
+    while(p != end)
+    {
+        const CharIn* const cur = p;
+        const code_point c = utf_traits<CharIn>::decode(p, end);
+        if(c == illegal || c == incomplete)
+            return validation_result{static_cast<size_t>(cur - s.data()), c};
+    }
+    return validation_result{s.size(), 0};
+}
+
+/// Validate s and every suffix following an invalid sequence
+template<typename CharIn>
+void test_validate(const std::basic_string<CharIn>& s)
+{
+    size_t pos = 0;
+    do
+    {
+        const std::basic_string<CharIn> tail = s.substr(pos);
+        const validation_result ref = validate_reference(tail);
+        const validation_result result = boost::nowide::utf::validate(tail.data(), tail.data() + tail.size());
+        TEST_EQ(result.offset, ref.offset);
+        TEST_EQ(result.error, ref.error);
+        TEST_EQ(result.valid(), ref.offset == tail.size());
+        boost::nowide::utf::code_point error;
+        TEST(boost::nowide::utf::find_first_invalid(tail.data(), tail.data() + tail.size(), &error)
+             == tail.data() + ref.offset);
+        TEST_EQ(error, ref.error);
+        pos += ref.offset + 1;
+    } while(pos < s.size());
+}
+
+void test_simple()
+{
+    using namespace boost::nowide::utf;
+    const std::string empty;
+    TEST(validate(empty.data(), empty.data()).valid());
+    for(const utf8_to_wide& t : roundtrip_tests)
+        TEST(validate_reference(std::string(t.utf8)).offset == std::strlen(t.utf8));
+    for(const utf8_to_wide& t : invalid_utf8_tests)
+        TEST(validate_reference(std::string(t.utf8)).error != 0);
+
+    const std::string s = "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d";
+    validation_result r = validate(s.data(), s.data() + s.size());
+    TEST(r.valid());
+    TEST_EQ(r.offset, s.size());
+    r = validate(s.data(), s.data() + s.size() - 1);
+    TEST_EQ(r.error, incomplete);
+    TEST_EQ(r.offset, s.size() - 2);
+    r = validate(s.data() + 1, s.data() + s.size());
+    TEST_EQ(r.error, illegal);
+    TEST_EQ(r.offset, 0u);
+}
+
+void test_embedded_sequences()
+{
+    // Place each test sequence at every position of a block and with a long valid prefix
+    const std::string padding = "Ab\xd7\xa9\xe2\x82\xa1\xf0\x90\x8c\xbc" "0123456789";
+    for(const utf8_to_wide& t : roundtrip_tests)
+    {
+        for(size_t i = 0; i < 70; i++)
+        {
+            std::string s;
+            while(s.size() < i)
+                s += padding;
+            test_validate(s + t.utf8 + padding + padding);
+            test_validate(std::string(i, 'x') + t.utf8 + std::string(i, 'y'));
+        }
+    }
+    for(const utf8_to_wide& t : invalid_utf8_tests)
+    {
+        for(size_t i = 0; i < 70; i++)
+        {
+            std::string s;
+            while(s.size() < i)
+                s += padding;
+            test_validate(s + t.utf8 + padding + padding);
+            test_validate(s + t.utf8);
+            test_validate(std::string(i, 'x') + t.utf8 + std::string(i, 'y'));
+        }
+    }
+}
+
+void test_long_strings()
+{
+    for(unsigned seed = 0; seed < 200; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        test_validate(s);
+        // Same without invalid sequences
+        const std::string valid = convert_reference<char>(convert_reference<char32_t>(s));
+        TEST(validate_reference(valid).offset == valid.size());
+        test_validate(valid);
+        for(size_t i = 1; i < 32 && i < valid.size(); i++)
+            test_validate(valid.substr(0, valid.size() - i));
+
+        test_validate(create_wide_test_string<char16_t>(seed, 1 + seed % 50));
+        test_validate(create_wide_test_string<char32_t>(seed, 1 + seed % 50));
+    }
+}
+
+template<typename Char>
+void test_is_ascii(const Char non_ascii)
+{
+    using boost::nowide::utf::is_ascii;
+    std::basic_string<Char> s;
+    TEST(is_ascii(s.data(), s.data()));
+    for(size_t len = 1; len < 150; len++)
+    {
+        s.assign(len, Char('a'));
+        s[len / 3] = Char(0x7F);
+        TEST(is_ascii(s.data(), s.data() + s.size()));
+        // A non-ASCII unit at each position and all alignments
+        for(size_t pos = 0; pos < len; pos++)
+        {
+            std::basic_string<Char> s2 = s;
+            s2[pos] = non_ascii;
+            TEST(!is_ascii(s2.data(), s2.data() + s2.size()));
+            TEST(is_ascii(s2.data(), s2.data() + pos));
+            TEST(is_ascii(s2.data() + pos + 1, s2.data() + s2.size()));
+        }
+    }
+}
+
+/// Count the code units which can start a code point one at a time
+template<typename CharIn>
+size_t count_codepoints_reference(const std::basic_string<CharIn>& s)
+{
+    size_t count = 0;
+    for(const CharIn c : s)
+    {
+        if(!boost::nowide::utf::utf_traits<CharIn>::is_trail(c))
+            ++count;
+    }
+    return count;
+}
+
+/// Check utf::count_codepoints for s and all its suffixes and prefixes of up to 64 units shorter
+template<typename CharIn>
+void test_count_codepoints(const std::basic_string<CharIn>& s)
+{
+    using boost::nowide::utf::count_codepoints;
+    const CharIn* const b = s.data();
+    const CharIn* const e = b + s.size();
+    TEST_EQ(count_codepoints(b, e), count_codepoints_reference(s));
+    for(size_t i = 1; i < 64 && i <= s.size(); i++)
+    {
+        TEST_EQ(count_codepoints(b + i, e), count_codepoints_reference(s.substr(i)));
+        TEST_EQ(count_codepoints(b, e - i), count_codepoints_reference(s.substr(0, s.size() - i)));
+    }
+}
+
+void test_count_codepoints()
+{
+    using boost::nowide::utf::count_codepoints;
+    const std::string empty;
+    TEST_EQ(count_codepoints(empty.data(), empty.data()), 0u);
+    const std::string hello = "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xf0\x9d\x92\x9e";
+    TEST_EQ(count_codepoints(hello.data(), hello.data() + hello.size()), 6u);
+    const std::u16string hello16 = u"\u05e9\u05dc\u05d5\u05dd \U0001D49E";
+    TEST_EQ(count_codepoints(hello16.data(), hello16.data() + hello16.size()), 6u);
+    const std::u32string hello32 = U"\u05e9\u05dc\u05d5\u05dd \U0001D49E";
+    TEST_EQ(count_codepoints(hello32.data(), hello32.data() + hello32.size()), 6u);
+
+    for(unsigned seed = 0; seed < 100; seed++)
+    {
+        const std::string s = create_utf8_test_string(seed, 1 + seed % 50);
+        test_count_codepoints(s);
+        // Valid input: Same as the number of decoded code points
+        const std::u32string s32 = convert_reference<char32_t>(s);
+        const std::string valid = convert_reference<char>(s32);
+        TEST_EQ(count_codepoints(valid.data(), valid.data() + valid.size()), s32.size());
+        const std::u16string s16 = convert_reference<char16_t>(s32);
+        TEST_EQ(count_codepoints(s16.data(), s16.data() + s16.size()), s32.size());
+        test_count_codepoints(create_wide_test_string<char16_t>(seed, 1 + seed % 50));
+    }
+    // Long enough for the per byte counters of the vectorized kernels to be summed up in between
+    std::string long_text;
+    std::u16string long_text16;
+    while(long_text16.size() < 600000)
+    {
+        long_text += "a\xd7\xa9\xe3\x82\x84\xf0\x9d\x92\x9e";
+        long_text16 += u"a\u05e9\u3084\U0001D49E";
+    }
+    TEST_EQ(count_codepoints(long_text.data(), long_text.data() + long_text.size()), long_text.size() / 10 * 4);
+    TEST_EQ(count_codepoints(long_text16.data(), long_text16.data() + long_text16.size()),
+            long_text16.size() / 5 * 4);
+}
+
+/// Check utf::sanitize against the conversion replacing invalid sequences
+template<typename Char>
+void test_sanitize(const std::basic_string<Char>& s)
+{
+    using boost::nowide::utf::sanitize;
+    const std::basic_string<Char> ref = convert_reference<Char>(s);
+    std::basic_string<Char> result = s;
+    const size_t replacements = sanitize(result);
+    TEST(result == ref);
+    TEST_EQ(replacements == 0, boost::nowide::utf::validate(s.data(), s.data() + s.size()).valid());
+    // Sanitized strings are valid and left alone
+    TEST_EQ(sanitize(result), 0u);
+    TEST(result == ref);
+
+    std::vector<Char> buf(s.begin(), s.end());
+    buf.resize(s.size() + 3 * s.size() + 1, Char(42));
+    Char* const end = sanitize(buf.data(), s.size(), buf.size());
+    TEST(end != nullptr);
+    TEST(std::basic_string<Char>(buf.data(), end) == ref);
+    if(ref.size() > s.size())
+    {
+        // Too small buffers are not modified
+        std::basic_string<Char> too_small = s;
+        TEST(sanitize(&too_small[0], s.size(), s.size()) == nullptr);
+        TEST(too_small == s);
+    }
+}
+
+void test_sanitize()
+{
+    using boost::nowide::utf::sanitize;
+    std::string valid = "Hello \xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d";
+    const char* const data = valid.data();
+    TEST_EQ(sanitize(valid), 0u);
+    TEST(valid.data() == data);
+    TEST(sanitize(&valid[0], valid.size(), valid.size()) == valid.data() + valid.size());
+    // The size of the text must not exceed the size of the buffer
+    std::string invalid = "a\xff" "b";
+    TEST(sanitize(&invalid[0], invalid.size(), invalid.size() - 1) == nullptr);
+    TEST(sanitize(&valid[0], valid.size(), valid.size() - 1) == nullptr);
+    TEST(invalid == "a\xff" "b");
+
+    std::string replacement;
+    boost::nowide::utf::utf_traits<char>::encode(BOOST_NOWIDE_REPLACEMENT_CHARACTER, std::back_inserter(replacement));
+    std::string s = "a\xff" "b\xc0\x80" "c";
+    TEST_EQ(sanitize(s), 3u);
+    TEST(s == "a" + replacement + "b" + replacement + replacement + "c");
+    // Shrinking (3 and 4 byte sequences replaced) and growing replacements
+    test_sanitize(std::string("\xe2\x82" "a\xf0\x90\x80" "b\xed\xa0\x80\x80\x80\x80\xff"));
+    test_sanitize(std::string("\xf0\x90\x80" "a\xff\xff\xff"));
+    test_sanitize(std::u16string(u"a\xD800" "b\xDC00\xD800\xDC00\xD800"));
+    test_sanitize(std::u32string(U"a\xD800" "b") + char32_t(0x110000));
+    for(unsigned seed = 0; seed < 100; seed++)
+    {
+        test_sanitize(create_utf8_test_string(seed, 1 + seed % 50));
+        test_sanitize(create_wide_test_string<char16_t>(seed, 1 + seed % 50));
+        test_sanitize(create_wide_test_string<char32_t>(seed, 1 + seed % 50));
+    }
+}
+
+// coverity [root_function]
+void test_main(int, char**, char**)
+{
+    std::cout << "- Simple cases" << std::endl;
+    test_simple();
+    std::cout << "- Sequences at all positions" << std::endl;
+    test_embedded_sequences();
+    std::cout << "- Long strings" << std::endl;
+    test_long_strings();
+    std::cout << "- ASCII" << std::endl;
+    test_is_ascii('\x80');
+    test_is_ascii('\xff');
+    test_is_ascii(u'\u0080');
+    test_is_ascii(u'\u0100');
+    test_is_ascii(u'\uFF00');
+    test_is_ascii(U'\U00010000');
+    test_is_ascii(char32_t(0x80000000u));
+    test_is_ascii(L'\u0180');
+    std::cout << "- Counting code points" << std::endl;
+    test_count_codepoints();
+    std::cout << "- Sanitizing" << std::endl;
+    test_sanitize();
+}